@@ -0,0 +1,147 @@
+import os
+import sys
+import time
+import shutil
+import random
+import signal
+import argparse
+import filecmp
+import tempfile
+import subprocess
+
+from emulador import NullModem
+
+# --- Benchmark do Modo Gateway ---
+# N emissores transferem ao mesmo tempo por N cabos emulados. Do lado
+# receptor, compara um processo 'receptor' por porta com um único processo
+# 'gateway' atendendo todas, medindo tempo de CPU e memória residente (RSS).
+
+PROTOCOLO = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'protocolo.py')
+RUN_TIMEOUT_SEC = 600
+CLOCK_TICKS = os.sysconf('SC_CLK_TCK')
+
+
+def proc_usage(pid: int):
+    """(segundos de CPU, pico de RSS em KiB) de um processo vivo e de seus filhos"""
+    cpu, rss = 0.0, 0
+    try:
+        with open(f"/proc/{pid}/stat") as f:
+            fields = f.read().rsplit(')', 1)[1].split()
+        cpu = (int(fields[11]) + int(fields[12])) / CLOCK_TICKS
+        with open(f"/proc/{pid}/status") as f:
+            rss = next(int(line.split()[1]) for line in f if line.startswith('VmHWM:'))
+        with open(f"/proc/{pid}/task/{pid}/children") as f:
+            children = [int(child) for child in f.read().split()]
+    except (OSError, StopIteration):
+        return cpu, rss
+    for child in children:
+        child_cpu, child_rss = proc_usage(child)
+        cpu += child_cpu
+        rss += child_rss
+    return cpu, rss
+
+
+def run(mode: str, src_path: str, ports: int, baud: int, workers: int):
+    workdir = tempfile.mkdtemp(prefix='bench_gateway_')
+    rx_dir = os.path.join(workdir, 'rx')
+    os.makedirs(rx_dir)
+    name = os.path.basename(src_path)
+    modems = [NullModem(baud) for _ in range(ports)]
+    rx_procs, tx_procs = [], []
+    log = open(os.path.join(workdir, 'bench.log'), 'w')
+    cpu, rss, outputs = 0.0, 0, []
+    try:
+        if mode == 'gateway':
+            cmd = [sys.executable, PROTOCOLO, 'gateway', '-b', str(baud), '--workers', str(workers),
+                   '--intervalo-metricas', '0', '-p'] + [modem.port_b for modem in modems]
+            rx_procs.append(subprocess.Popen(cmd, cwd=rx_dir, stdout=log, stderr=subprocess.STDOUT))
+            outputs = [os.path.join(rx_dir, f"recebido_{os.path.basename(modem.port_b)}_{name}") for modem in modems]
+        else:
+            for i, modem in enumerate(modems):
+                port_dir = os.path.join(rx_dir, str(i))
+                os.makedirs(port_dir)
+                rx_procs.append(subprocess.Popen([sys.executable, PROTOCOLO, 'receptor', '-p', modem.port_b,
+                                                  '-b', str(baud)], cwd=port_dir, stdout=log,
+                                                 stderr=subprocess.STDOUT))
+                outputs.append(os.path.join(port_dir, f"recebido_{name}"))
+        time.sleep(1.0)
+
+        start = time.monotonic()
+        for modem in modems:
+            tx_procs.append(subprocess.Popen([sys.executable, PROTOCOLO, 'emissor', '-p', modem.port_a,
+                                              '-b', str(baud), '-f', src_path], stdout=log,
+                                             stderr=subprocess.STDOUT))
+        for proc in tx_procs:
+            proc.wait(timeout=RUN_TIMEOUT_SEC)
+
+        if mode == 'gateway':
+            # Espera os ENDs serem processados e mede antes de encerrar
+            deadline = time.monotonic() + 10
+            while time.monotonic() < deadline and not all(
+                    os.path.exists(out) and not os.path.exists(out + '.temp') for out in outputs):
+                time.sleep(0.1)
+            elapsed = time.monotonic() - start
+            cpu, rss = proc_usage(rx_procs[0].pid)
+            # SIGINT só no processo pai, como faria um gerenciador de serviços
+            rx_procs[0].send_signal(signal.SIGINT)
+            rx_procs[0].wait(timeout=30)
+        else:
+            for proc in rx_procs:
+                _, _, usage = os.wait4(proc.pid, 0)
+                proc.returncode = 0
+                cpu += usage.ru_utime + usage.ru_stime
+                rss += usage.ru_maxrss
+            elapsed = time.monotonic() - start
+    finally:
+        for proc in rx_procs + tx_procs:
+            if proc.poll() is None:
+                proc.kill()
+                proc.wait()
+        for modem in modems:
+            modem.close()
+        log.close()
+
+    ok = all(os.path.exists(out) and filecmp.cmp(src_path, out, shallow=False) for out in outputs)
+    if ok:
+        shutil.rmtree(workdir, ignore_errors=True)
+    else:
+        print(f"[ERRO] Saída divergente; logs em {workdir}")
+    return elapsed, cpu, rss, ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark do gateway contra um receptor por porta")
+    parser.add_argument('-n', '--portas', type=int, default=32, help="Portas (transferências simultâneas)")
+    parser.add_argument('-t', '--tamanho', type=int, default=20000, help="Bytes enviados por porta")
+    parser.add_argument('-b', '--baud', type=int, default=115200, help="Taxa emulada de cada cabo")
+    parser.add_argument('--workers', type=int, default=1, help="Processos de trabalho do gateway")
+    parser.add_argument('--semente', type=int, default=1)
+    args = parser.parse_args()
+
+    src = tempfile.NamedTemporaryFile(prefix='bench_gateway_', suffix='.bin', delete=False)
+    src.write(random.Random(args.semente).randbytes(args.tamanho))
+    src.close()
+
+    results = {}
+    failed = False
+    try:
+        for mode in ('processos', 'gateway'):
+            elapsed, cpu, rss, ok = run(mode, src.name, args.portas, args.baud, args.workers)
+            results[mode] = (elapsed, cpu, rss)
+            failed = failed or not ok
+            print(f"[BENCH] {mode}: {args.portas} portas em {elapsed:.2f} s | CPU {cpu:.2f} s | "
+                  f"RSS {rss / 1024:.1f} MiB | ok={ok}")
+    finally:
+        os.remove(src.name)
+
+    base = results['processos']
+    print("\n| Receptor | Tempo (s) | CPU (s) | RSS (MiB) | CPU relativa | RSS relativa |")
+    print("|----------|-----------|---------|-----------|--------------|--------------|")
+    for mode, (elapsed, cpu, rss) in results.items():
+        print(f"| {mode} | {elapsed:.2f} | {cpu:.2f} | {rss / 1024:.1f} | "
+              f"{cpu / max(base[1], 1e-9) * 100:.0f}% | {rss / max(base[2], 1) * 100:.0f}% |")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,110 @@
+import os
+import sys
+import time
+import shutil
+import random
+import argparse
+import filecmp
+import tempfile
+import subprocess
+
+from emulador import NullModem
+
+# --- Benchmark do Modo Retransmissor (Dois Enlaces Emulados) ---
+# Origem -> relay -> destino sobre dois cabos emulados com baud rates
+# diferentes. Compara o tempo de ponta a ponta com a transferência direta
+# em cada enlace isolado: com cut-through, o total deve ficar próximo do
+# enlace mais lento, e não da soma dos dois (store-and-forward).
+
+PROTOCOLO = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'protocolo.py')
+RUN_TIMEOUT_SEC = 600
+
+
+def spawn(workdir: str, role: str, args: list):
+    log = open(os.path.join(workdir, f"{role}.log"), 'w')
+    return subprocess.Popen([sys.executable, PROTOCOLO] + args, cwd=os.path.join(workdir, role),
+                            stdout=log, stderr=subprocess.STDOUT)
+
+
+def run(src_path: str, bauds: list):
+    """Um enlace (transferência direta) ou dois (via relay); devolve segundos e conferência"""
+    workdir = tempfile.mkdtemp(prefix='bench_relay_')
+    for role in ('tx', 'relay', 'rx'):
+        os.makedirs(os.path.join(workdir, role))
+    name = os.path.basename(src_path)
+    shutil.copy(src_path, os.path.join(workdir, 'tx', name))
+    modems = [NullModem(baud) for baud in bauds]
+    procs = []
+    try:
+        rx_port = modems[-1].port_b
+        procs.append(spawn(workdir, 'rx', ['receptor', '-p', rx_port, '-b', str(bauds[-1])]))
+        if len(modems) == 2:
+            procs.append(spawn(workdir, 'relay', ['retransmissor', '-p', modems[0].port_b, '-b', str(bauds[0]),
+                                                  '-s', modems[1].port_a, '--baud-saida', str(bauds[1])]))
+        time.sleep(0.5)
+        start = time.monotonic()
+        procs.append(spawn(workdir, 'tx', ['emissor', '-p', modems[0].port_a, '-b', str(bauds[0]), '-f', name]))
+        try:
+            procs[0].wait(timeout=RUN_TIMEOUT_SEC)
+        except subprocess.TimeoutExpired:
+            pass
+        elapsed = time.monotonic() - start
+    finally:
+        for proc in procs:
+            if proc.poll() is None:
+                proc.kill()
+                proc.wait()
+        for modem in modems:
+            modem.close()
+
+    output = os.path.join(workdir, 'rx', f"recebido_{name}")
+    ok = os.path.exists(output) and filecmp.cmp(src_path, output, shallow=False)
+    if ok:
+        shutil.rmtree(workdir, ignore_errors=True)
+    else:
+        print(f"[ERRO] Saída divergente; logs em {workdir}")
+    return elapsed, ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark do retransmissor sobre dois enlaces emulados")
+    parser.add_argument('-f', '--file', help="Arquivo a transferir (padrão: aleatório com --tamanho)")
+    parser.add_argument('-t', '--tamanho', type=int, default=20000, help="Bytes do arquivo aleatório")
+    parser.add_argument('--bauds', type=int, nargs=2, default=[115200, 19200], metavar=('RAPIDO', 'LENTO'))
+    parser.add_argument('--semente', type=int, default=1)
+    args = parser.parse_args()
+
+    src_path = args.file
+    tmp_src = None
+    if not src_path:
+        tmp_src = tempfile.NamedTemporaryFile(prefix='bench_relay_', suffix='.bin', delete=False)
+        tmp_src.write(random.Random(args.semente).randbytes(args.tamanho))
+        tmp_src.close()
+        src_path = tmp_src.name
+
+    fast, slow = args.bauds
+    scenarios = [('direto rápido', [fast]), ('direto lento', [slow]),
+                 ('relay rápido->lento', [fast, slow]), ('relay lento->rápido', [slow, fast])]
+    results = {}
+    failed = False
+    try:
+        for label, bauds in scenarios:
+            elapsed, ok = run(src_path, bauds)
+            results[label] = elapsed
+            failed = failed or not ok
+            print(f"[BENCH] {label} ({' -> '.join(map(str, bauds))} baud): {elapsed:.2f} s, ok={ok}")
+    finally:
+        if tmp_src:
+            os.remove(src_path)
+
+    store_forward = results['direto rápido'] + results['direto lento']
+    print("\n| Cenário | Tempo (s) | / enlace lento | / soma dos enlaces |")
+    print("|---------|-----------|----------------|--------------------|")
+    for label, _ in scenarios:
+        print(f"| {label} | {results[label]:.2f} | {results[label] / results['direto lento']:.2f} | "
+              f"{results[label] / store_forward:.2f} |")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
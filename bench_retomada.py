@@ -0,0 +1,204 @@
+import os
+import sys
+import time
+import json
+import shutil
+import random
+import signal
+import argparse
+import filecmp
+import tempfile
+import subprocess
+
+from emulador import NullModem
+
+# --- Benchmark de Interrupção e Retomada ---
+# Mata e reinicia emissor e receptor em pontos aleatórios e mede quanto a
+# retomada (checkpoint .temp + handshake START/ACK_STATUS) custa em bytes na
+# linha e em segundos, comparado com a transferência sem interrupções.
+
+PROTOCOLO = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'protocolo.py')
+RUN_TIMEOUT_SEC = 600
+EMISSOR_GRACE_SEC = 1.0
+
+
+class Transfer:
+    """Uma transferência supervisionada entre as duas pontas do emulador"""
+
+    def __init__(self, workdir: str, src_path: str, tx_port: str, rx_port: str, baud: int):
+        self.workdir = workdir
+        self.src_path = src_path
+        self.tx_port = tx_port
+        self.rx_port = rx_port
+        self.baud = baud
+        self.name = os.path.basename(src_path)
+        self.output_path = os.path.join(workdir, 'rx', f"recebido_{self.name}")
+        os.makedirs(os.path.join(workdir, 'rx'), exist_ok=True)
+        os.makedirs(os.path.join(workdir, 'tx'), exist_ok=True)
+        shutil.copy(src_path, os.path.join(workdir, 'tx', self.name))
+        self.procs = {'emissor': None, 'receptor': None}
+        self.starts = {'emissor': 0, 'receptor': 0}
+
+    def start(self, role: str):
+        if role == 'emissor':
+            cmd = [sys.executable, PROTOCOLO, 'emissor', '-p', self.tx_port, '-b', str(self.baud), '-f', self.name]
+            cwd = os.path.join(self.workdir, 'tx')
+        else:
+            cmd = [sys.executable, PROTOCOLO, 'receptor', '-p', self.rx_port, '-b', str(self.baud)]
+            cwd = os.path.join(self.workdir, 'rx')
+        log = open(os.path.join(self.workdir, f"{role}.log"), 'a')
+        self.procs[role] = subprocess.Popen(cmd, cwd=cwd, stdout=log, stderr=subprocess.STDOUT)
+        self.starts[role] += 1
+
+    def running(self, role: str) -> bool:
+        proc = self.procs[role]
+        return proc is not None and proc.poll() is None
+
+    def done(self) -> bool:
+        return (not self.running('receptor')
+                and os.path.exists(self.output_path)
+                and not os.path.exists(self.output_path + '.temp')
+                and os.path.getsize(self.output_path) == os.path.getsize(self.src_path))
+
+    def kill(self, role: str, sig: int):
+        proc = self.procs[role]
+        if proc is None or proc.poll() is not None:
+            return
+        proc.send_signal(sig)
+        try:
+            proc.wait(timeout=15)
+        except subprocess.TimeoutExpired:
+            proc.kill()
+            proc.wait()
+
+    def stop_all(self):
+        for role in self.procs:
+            self.kill(role, signal.SIGKILL)
+
+
+def run_transfer(modem: NullModem, src_path: str, swap: bool, baud: int,
+                 interruptions: int, min_gap: float, max_gap: float, sig_mode: str, rng: random.Random):
+    """Executa uma transferência (com ou sem interrupções) e devolve suas medidas"""
+    workdir = tempfile.mkdtemp(prefix='bench_retomada_')
+    tx_port, rx_port = (modem.port_b, modem.port_a) if swap else (modem.port_a, modem.port_b)
+    transfer = Transfer(workdir, src_path, tx_port, rx_port, baud)
+    modem.reset_counters()
+
+    start = time.monotonic()
+    transfer.start('receptor')
+    time.sleep(0.3)
+    transfer.start('emissor')
+
+    kills = 0
+    next_kill = start + rng.uniform(min_gap, max_gap)
+    try:
+        while time.monotonic() - start < RUN_TIMEOUT_SEC:
+            now = time.monotonic()
+            if transfer.done():
+                break
+
+            if kills < interruptions and now >= next_kill:
+                victims = [role for role in ('emissor', 'receptor') if transfer.running(role)]
+                if victims:
+                    role = rng.choice(victims)
+                    sig = {'int': signal.SIGINT, 'kill': signal.SIGKILL}.get(sig_mode) or \
+                        rng.choice([signal.SIGINT, signal.SIGKILL])
+                    transfer.kill(role, sig)
+                    kills += 1
+                next_kill = time.monotonic() + rng.uniform(min_gap, max_gap)
+
+            if not transfer.running('receptor') and not transfer.done():
+                transfer.start('receptor')
+                time.sleep(0.3)
+            if not transfer.running('emissor') and not transfer.done():
+                # O emissor pode ter terminado normalmente: dá tempo ao receptor de ver o END
+                deadline = time.monotonic() + EMISSOR_GRACE_SEC
+                while time.monotonic() < deadline and not transfer.done():
+                    time.sleep(0.05)
+                if not transfer.done():
+                    transfer.start('emissor')
+            time.sleep(0.05)
+        elapsed = time.monotonic() - start
+    finally:
+        transfer.stop_all()
+
+    ok = transfer.done() and filecmp.cmp(src_path, transfer.output_path, shallow=False)
+    result = {
+        'segundos': elapsed,
+        'bytes': modem.total_bytes(),
+        'interrupcoes': kills,
+        'inicios_emissor': transfer.starts['emissor'],
+        'inicios_receptor': transfer.starts['receptor'],
+        'ok': ok,
+    }
+    if ok:
+        shutil.rmtree(workdir, ignore_errors=True)
+    else:
+        result['diretorio'] = workdir
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark de interrupção/retomada do protocolo")
+    parser.add_argument('-f', '--file', required=True, help="Arquivo a transferir")
+    parser.add_argument('-n', '--interrupcoes', type=int, default=5, help="Interrupções por transferência")
+    parser.add_argument('-r', '--rodadas', type=int, default=1, help="Transferências com interrupção por cenário")
+    parser.add_argument('--transportes', nargs='+', default=['pty', 'emulador'], choices=['pty', 'emulador'])
+    parser.add_argument('-b', '--baud', type=int, default=115200, help="Taxa do transporte 'emulador'")
+    parser.add_argument('--intervalo', type=float, nargs=2, default=[0.5, 3.0], metavar=('MIN', 'MAX'),
+                        help="Intervalo aleatório entre interrupções (s)")
+    parser.add_argument('--sinal', choices=['int', 'kill', 'misto'], default='misto',
+                        help="int = Ctrl+C, kill = SIGKILL, misto = sorteado a cada interrupção")
+    parser.add_argument('--semente', type=int, default=1, help="Semente dos pontos de interrupção")
+    parser.add_argument('--json', help="Grava os resultados neste arquivo")
+    args = parser.parse_args()
+
+    rng = random.Random(args.semente)
+    results = []
+    failed = False
+
+    for transport in args.transportes:
+        modem = NullModem(args.baud if transport == 'emulador' else 0)
+        try:
+            for swap in (False, True):
+                direction = 'B->A' if swap else 'A->B'
+                base = run_transfer(modem, args.file, swap, args.baud, 0, 0, 0, args.sinal, rng)
+                print(f"[BENCH] {transport} {direction} sem interrupção: "
+                      f"{base['segundos']:.2f} s, {base['bytes']} bytes, ok={base['ok']}")
+                for rodada in range(args.rodadas):
+                    chaos = run_transfer(modem, args.file, swap, args.baud, args.interrupcoes,
+                                         args.intervalo[0], args.intervalo[1], args.sinal, rng)
+                    chaos['extra_segundos'] = chaos['segundos'] - base['segundos']
+                    chaos['extra_bytes'] = chaos['bytes'] - base['bytes']
+                    failed = failed or not (base['ok'] and chaos['ok'])
+                    results.append({'transporte': transport, 'sentido': direction, 'rodada': rodada,
+                                    'base': base, 'interrompida': chaos})
+                    print(f"[BENCH] {transport} {direction} #{rodada + 1}: {chaos['interrupcoes']} interrupções, "
+                          f"+{chaos['extra_segundos']:.2f} s, +{chaos['extra_bytes']} bytes, ok={chaos['ok']}")
+                    if not chaos['ok']:
+                        print(f"[ERRO] Saída divergente; logs em {chaos.get('diretorio')}")
+        finally:
+            modem.close()
+
+    total_kills = sum(r['interrompida']['interrupcoes'] for r in results)
+    extra_s = sum(r['interrompida']['extra_segundos'] for r in results)
+    extra_b = sum(r['interrompida']['extra_bytes'] for r in results)
+    print("\n| Transporte | Sentido | Interrupções | Base (s) | Extra (s) | Base (bytes) | Extra (bytes) | OK |")
+    print("|------------|---------|--------------|----------|-----------|--------------|---------------|----|")
+    for r in results:
+        base, chaos = r['base'], r['interrompida']
+        print(f"| {r['transporte']} | {r['sentido']} | {chaos['interrupcoes']} | {base['segundos']:.2f} | "
+              f"{chaos['extra_segundos']:.2f} | {base['bytes']} | {chaos['extra_bytes']} | "
+              f"{'sim' if chaos['ok'] else 'NÃO'} |")
+    if total_kills:
+        print(f"\n[BENCH] Custo médio por interrupção: {extra_s / total_kills:.2f} s, "
+              f"{extra_b / total_kills:.0f} bytes.")
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(results, f, indent=2)
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,89 @@
+import os
+import sys
+import random
+import shutil
+import argparse
+import filecmp
+import tempfile
+import threading
+
+import protocolo
+from emulador import RS485Bus, BITS_PER_BYTE
+
+# --- Benchmark do Modo RS-485 Multiponto ---
+# Mestre e nós rodam em threads sobre o barramento simulado, com atraso de
+# inversão (turnaround) configurável. Mede a utilização do barramento e a
+# latência de acesso de cada nó para diferentes tamanhos de lote.
+
+
+def run_bus(nodes: int, size: int, baud: int, turnaround: float, batch: int, seed: int):
+    workdir = tempfile.mkdtemp(prefix='bench_rs485_')
+    rng = random.Random(seed)
+    bus = RS485Bus(baud, turnaround, seed)
+    master_port = bus.attach()
+
+    sources = {}
+    threads = []
+    results = {}
+    for addr in range(1, nodes + 1):
+        path = os.path.join(workdir, f"no{addr}.bin")
+        with open(path, 'wb') as f:
+            f.write(bytes(rng.getrandbits(8) for _ in range(size)))
+        sources[addr] = path
+        port = bus.attach()
+        thread = threading.Thread(
+            target=lambda a=addr, p=port, f=path: results.__setitem__(a, protocolo.rs485_node(p, a, f, turnaround)),
+            daemon=True)
+        threads.append(thread)
+        thread.start()
+
+    outdir = os.path.join(workdir, 'mestre')
+    os.makedirs(outdir)
+    state, elapsed = protocolo.rs485_master(master_port, list(sources), batch, turnaround, outdir)
+    for thread in threads:
+        thread.join(timeout=5)
+
+    ok = all(filecmp.cmp(src, os.path.join(outdir, f"recebido_no{addr}_{os.path.basename(src)}"), shallow=False)
+             if os.path.exists(os.path.join(outdir, f"recebido_no{addr}_{os.path.basename(src)}")) else False
+             for addr, src in sources.items())
+    if ok:
+        shutil.rmtree(workdir, ignore_errors=True)
+    return state, elapsed, bus, ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark RS-485 half-duplex com polling (barramento simulado)")
+    parser.add_argument('-n', '--nos', type=int, default=4, help="Quantidade de nós escravos")
+    parser.add_argument('-t', '--tamanho', type=int, default=5000, help="Bytes enviados por nó")
+    parser.add_argument('-b', '--baud', type=int, default=115200)
+    parser.add_argument('--turnaround', type=float, default=2.0, help="Atraso de inversão do barramento em ms")
+    parser.add_argument('--lotes', type=int, nargs='+', default=[1, 4, 16], help="Quadros por concessão a comparar")
+    parser.add_argument('--semente', type=int, default=1)
+    args = parser.parse_args()
+
+    turnaround = args.turnaround / 1000
+    failed = False
+    summary = []
+    for batch in args.lotes:
+        print(f"\n[BENCH] {args.nos} nós x {args.tamanho} bytes, lote {batch}, "
+              f"turnaround {args.turnaround:.1f} ms @ {args.baud} baud")
+        state, elapsed, bus, ok = run_bus(args.nos, args.tamanho, args.baud, turnaround, batch, args.semente)
+        protocolo.print_rs485_metrics(state, elapsed)
+        useful = sum(node['bytes'] for node in state.values())
+        efficiency = useful * BITS_PER_BYTE / args.baud / elapsed
+        print(f"[METRICAS] Utilização do barramento {bus.utilisation(elapsed) * 100:.1f}% | "
+              f"carga útil {efficiency * 100:.1f}% | transmissões={bus.transmissions} colisões={bus.collisions} | "
+              f"ok={ok}")
+        summary.append((batch, elapsed, bus.utilisation(elapsed), efficiency, bus.collisions, ok))
+        failed = failed or not ok
+
+    print("\n| Lote | Tempo (s) | Utilização | Carga útil | Colisões | OK |")
+    print("|------|-----------|------------|------------|----------|----|")
+    for batch, elapsed, util, eff, collisions, ok in summary:
+        print(f"| {batch} | {elapsed:.2f} | {util * 100:.1f}% | {eff * 100:.1f}% | {collisions} | "
+              f"{'sim' if ok else 'NÃO'} |")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,232 @@
+import os
+import pty
+import tty
+import time
+import random
+import queue
+import threading
+
+# --- Emulador de Cabo Serial (Null-Modem) ---
+# Liga dois pseudo-terminais como se fossem as duas pontas do cabo DB9
+# (pino 3 de um lado no pino 2 do outro). Disponível em Linux/WSL.
+
+BITS_PER_BYTE = 10  # 8N1: start + 8 dados + stop
+
+
+class NullModem:
+    """
+    Par de portas virtuais interligadas. Com 'baud' > 0 o emulador respeita o
+    tempo de cada byte na linha; com 0 os bytes passam na velocidade do pty.
+    Conta os bytes que atravessam o cabo em cada sentido.
+    """
+
+    def __init__(self, baud: int = 0, burst_prob: float = 0.0, burst_len: int = 0, seed: int = 1,
+                 delay: float = 0.0):
+        self.baud = baud
+        # Atraso de propagação em cada sentido (servidor serial TCP, vários saltos)
+        self.delay = delay
+        # Ruído em rajada: probabilidade por KiB transmitido de apagar 'burst_len' bytes seguidos
+        self.burst_prob = burst_prob
+        self.burst_len = burst_len
+        self.bursts = 0
+        self.rng = random.Random(seed)
+        self.bytes_a_to_b = 0
+        self.bytes_b_to_a = 0
+        self.lock = threading.Lock()
+        self.running = True
+
+        self.master_a, self.slave_a = pty.openpty()
+        self.master_b, self.slave_b = pty.openpty()
+        for fd in (self.slave_a, self.slave_b):
+            tty.setraw(fd)
+        # Os descritores escravos ficam abertos: as portas sobrevivem ao
+        # encerramento e reinício dos processos que as usam
+        self.port_a = os.ttyname(self.slave_a)
+        self.port_b = os.ttyname(self.slave_b)
+
+        self.threads = []
+        for src, dst, counter in ((self.master_a, self.master_b, 'bytes_a_to_b'),
+                                  (self.master_b, self.master_a, 'bytes_b_to_a')):
+            in_transit = queue.Queue()
+            self.threads.append(threading.Thread(target=self._forward, args=(src, in_transit, counter), daemon=True))
+            self.threads.append(threading.Thread(target=self._deliver, args=(in_transit, dst), daemon=True))
+        for thread in self.threads:
+            thread.start()
+
+    def _forward(self, src: int, in_transit: queue.Queue, counter: str):
+        while self.running:
+            try:
+                data = os.read(src, 4096)
+            except OSError:
+                time.sleep(0.01)
+                continue
+            if not data:
+                continue
+            if self.baud:
+                time.sleep(len(data) * BITS_PER_BYTE / self.baud)
+            with self.lock:
+                setattr(self, counter, getattr(self, counter) + len(data))
+                data = self._add_noise(data)
+            in_transit.put((time.monotonic() + self.delay, data))
+
+    def _deliver(self, in_transit: queue.Queue, dst: int):
+        while self.running:
+            arrival, data = in_transit.get()
+            wait = arrival - time.monotonic()
+            if wait > 0:
+                time.sleep(wait)
+            try:
+                os.write(dst, data)
+            except OSError:
+                pass
+
+    def _add_noise(self, data: bytes) -> bytes:
+        if not self.burst_prob or self.rng.random() >= self.burst_prob * len(data) / 1024:
+            return data
+        noisy = bytearray(data)
+        start = self.rng.randrange(len(noisy))
+        for i in range(start, min(len(noisy), start + self.burst_len)):
+            noisy[i] = self.rng.randrange(256)
+        self.bursts += 1
+        return bytes(noisy)
+
+    def total_bytes(self) -> int:
+        with self.lock:
+            return self.bytes_a_to_b + self.bytes_b_to_a
+
+    def reset_counters(self):
+        with self.lock:
+            self.bytes_a_to_b = 0
+            self.bytes_b_to_a = 0
+
+    def close(self):
+        self.running = False
+        for fd in (self.master_a, self.master_b, self.slave_a, self.slave_b):
+            try:
+                os.close(fd)
+            except OSError:
+                pass
+
+
+# --- Barramento RS-485 Simulado (Multiponto, Half-Duplex) ---
+class BusPort:
+    """Uma derivação do barramento, com a interface de pyserial usada pelo protocolo"""
+
+    def __init__(self, bus):
+        self.bus = bus
+        self.buffer = bytearray()
+        self.cond = threading.Condition()
+        self.timeout = 1
+        self.baudrate = bus.baud
+        self.is_open = True
+
+    def _receive(self, data: bytes):
+        with self.cond:
+            self.buffer += data
+            self.cond.notify_all()
+
+    def read(self, size: int = 1) -> bytes:
+        deadline = None if self.timeout is None else time.monotonic() + self.timeout
+        with self.cond:
+            while len(self.buffer) < size:
+                remaining = None if deadline is None else deadline - time.monotonic()
+                if remaining is not None and remaining <= 0:
+                    break
+                self.cond.wait(remaining)
+            data = bytes(self.buffer[:size])
+            del self.buffer[:size]
+            return data
+
+    def write(self, data: bytes) -> int:
+        self.bus.transmit(self, data)
+        return len(data)
+
+    @property
+    def in_waiting(self) -> int:
+        return len(self.buffer)
+
+    def flushInput(self):
+        with self.cond:
+            self.buffer.clear()
+
+    def flushOutput(self):
+        pass
+
+    def close(self):
+        self.is_open = False
+
+
+class RS485Bus:
+    """
+    Par trançado compartilhado: todas as derivações ouvem tudo o que é
+    transmitido. Cada transmissão ocupa a linha pelo tempo dos bytes no baud
+    rate, e o driver de quem transmitiu continua habilitado por 'turnaround'
+    segundos depois do último byte. Quem começar a falar antes disso (ou por
+    cima de outra transmissão) colide e os bytes chegam corrompidos.
+    """
+
+    def __init__(self, baud: int = 115200, turnaround: float = 0.0, seed: int = 1):
+        self.baud = baud
+        self.turnaround = turnaround
+        self.ports = []
+        self.lock = threading.Lock()
+        self.rng = random.Random(seed)
+        self.busy_until = 0.0
+        self.driver_until = 0.0
+        self.last_talker = None
+        self.busy_time = 0.0
+        self.bytes_on_bus = 0
+        self.transmissions = 0
+        self.collisions = 0
+
+    def attach(self) -> BusPort:
+        port = BusPort(self)
+        self.ports.append(port)
+        return port
+
+    def transmit(self, talker: BusPort, data: bytes):
+        duration = len(data) * BITS_PER_BYTE / self.baud
+        with self.lock:
+            now = time.monotonic()
+            collided = now < self.busy_until or (talker is not self.last_talker and now < self.driver_until)
+            start = max(now, self.busy_until)
+            self.busy_until = start + duration
+            self.driver_until = self.busy_until + self.turnaround
+            self.last_talker = talker
+            self.busy_time += duration
+            self.bytes_on_bus += len(data)
+            self.transmissions += 1
+            if collided:
+                self.collisions += 1
+        time.sleep(max(0.0, start + duration - time.monotonic()))
+        if collided:
+            noisy = bytearray(data)
+            for i in self.rng.sample(range(len(noisy)), max(1, len(noisy) // 8)):
+                noisy[i] ^= 0xFF
+            data = bytes(noisy)
+        for port in self.ports:
+            if port is not talker:
+                port._receive(data)
+
+    def utilisation(self, elapsed: float) -> float:
+        return self.busy_time / elapsed if elapsed > 0 else 0.0
+
+
+if __name__ == "__main__":
+    import argparse
+    parser = argparse.ArgumentParser(description="Cabo serial emulado entre duas portas virtuais")
+    parser.add_argument('-b', '--baud', type=int, default=0, help="Taxa emulada (0 = sem limite)")
+    parser.add_argument('--ruido', type=float, default=0.0, help="Probabilidade de rajada de ruído por KiB")
+    parser.add_argument('--rajada-ruido', type=int, default=32, help="Bytes destruídos por rajada")
+    parser.add_argument('--semente', type=int, default=1, help="Semente do ruído")
+    parser.add_argument('--atraso', type=float, default=0.0, help="Atraso de propagação em ms (cada sentido)")
+    args = parser.parse_args()
+
+    modem = NullModem(args.baud, args.ruido, args.rajada_ruido, args.semente, args.atraso / 1000)
+    print(f"Portas emuladas: {modem.port_a} <-> {modem.port_b} (Ctrl+C encerra)")
+    try:
+        while True:
+            time.sleep(1)
+    except KeyboardInterrupt:
+        print(f"\nBytes A->B: {modem.bytes_a_to_b} | B->A: {modem.bytes_b_to_a} | Rajadas de ruído: {modem.bursts}")
+        modem.close()
@@ -0,0 +1,263 @@
+import os
+import sys
+import json
+import zlib
+import random
+import hashlib
+import argparse
+import tempfile
+
+# --- Gerador de Corpus para Benchmarks ---
+# Gera, a partir de uma semente fixa, arquivos com propriedades controladas
+# (entropia, esparsidade, pequenas alterações, muitos arquivos pequenos e
+# fluxos grandes) e um manifesto com checksums de referência. Mesma semente
+# e mesma versão do gerador => mesmos bytes em qualquer máquina.
+
+GENERATOR_VERSION = 1
+CHUNK_SIZE = 1024 * 1024
+MANIFEST_NAME = 'MANIFESTO.json'
+SUMS_NAME = 'SHA256SUMS'
+PROFILES = ['aleatorio', 'texto', 'esparso', 'modificado', 'pequenos', 'fluxo']
+DEFAULT_SEED = 20251118
+# Corpus pequeno cujos checksums estão versionados no repositório: regenerá-lo
+# em outra máquina (ou com outro Python) e comparar detecta deriva do gerador
+REFERENCE_PATH = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'corpus_referencia.sha256')
+REFERENCE_PARAMS = {'size': 64 * 1024, 'stream_size': 4 * 1024 * 1024, 'small_count': 20, 'versions': 3}
+
+SYLLABLES = ['ba', 'ca', 'da', 'de', 'do', 'fe', 'ga', 'la', 'le', 'li', 'lo', 'ma', 'me', 'mi', 'na',
+             'ne', 'no', 'pa', 'pe', 'po', 'ra', 're', 'ri', 'ro', 'sa', 'se', 'so', 'ta', 'te', 'to',
+             'va', 've', 'xa', 'ção', 'são', 'nho', 'lha', 'que', 'gui', 'tra', 'pro', 'com', 'em']
+
+
+def derive_rng(seed: int, name: str) -> random.Random:
+    """Cada arquivo tem o próprio gerador: não depende de quais perfis foram pedidos"""
+    digest = hashlib.sha256(f"{GENERATOR_VERSION}:{seed}:{name}".encode('utf-8')).digest()
+    return random.Random(int.from_bytes(digest[:8], 'little'))
+
+
+# --- Fontes de Conteúdo ---
+def random_chunks(rng: random.Random, size: int):
+    while size > 0:
+        n = min(size, CHUNK_SIZE)
+        yield rng.randbytes(n)
+        size -= n
+
+
+def build_vocabulary(rng: random.Random, words: int = 2000) -> list:
+    vocab = set()
+    while len(vocab) < words:
+        vocab.add(''.join(rng.choice(SYLLABLES) for _ in range(rng.randint(1, 4))))
+    return sorted(vocab)
+
+
+def text_chunks(rng: random.Random, size: int):
+    """Texto com distribuição de palavras tipo Zipf, pontuação e quebras de linha"""
+    vocab = build_vocabulary(rng)
+    weights = [1 / (rank + 1) for rank in range(len(vocab))]
+    produced = 0
+    while produced < size:
+        words = rng.choices(vocab, weights, k=4096)
+        lines = []
+        for i in range(0, len(words), 12):
+            line = ' '.join(words[i:i + 12])
+            lines.append(line[0].upper() + line[1:] + rng.choice(['.', '.', ',', ';', '!', '?']))
+        chunk = ('\n'.join(lines) + '\n').encode('utf-8')[:size - produced]
+        produced += len(chunk)
+        yield chunk
+
+
+def sparse_chunks(rng: random.Random, size: int, density: float = 0.02):
+    """Predominantemente zeros, com trechos aleatórios curtos (imagens de disco, tabelas)"""
+    produced = 0
+    while produced < size:
+        n = min(CHUNK_SIZE, size - produced)
+        chunk = bytearray(n)
+        for _ in range(max(1, int(n * density / 64))):
+            start = rng.randrange(n)
+            run = rng.randbytes(rng.randint(1, 128))
+            chunk[start:start + len(run)] = run[:n - start]
+        produced += n
+        yield bytes(chunk)
+
+
+def mixed_chunks(rng: random.Random, size: int):
+    """Fluxo longo alternando trechos aleatórios, de texto e esparsos"""
+    sources = [random_chunks, text_chunks, sparse_chunks]
+    produced = 0
+    while produced < size:
+        n = min(size - produced, rng.randint(1, 64) * CHUNK_SIZE)
+        source = rng.choice(sources)
+        for chunk in source(random.Random(rng.getrandbits(64)), n):
+            produced += len(chunk)
+            yield chunk
+
+
+def mutate(rng: random.Random, data: bytes, edits: int) -> bytes:
+    """Pequenas alterações (troca, inserção e remoção) para testes de delta"""
+    out = bytearray(data)
+    for _ in range(edits):
+        pos = rng.randrange(max(1, len(out)))
+        kind = rng.choice(['troca', 'insercao', 'remocao'])
+        length = rng.randint(1, 64)
+        if kind == 'troca':
+            out[pos:pos + length] = rng.randbytes(len(out[pos:pos + length]))
+        elif kind == 'insercao':
+            out[pos:pos] = rng.randbytes(length)
+        else:
+            del out[pos:pos + length]
+    return bytes(out)
+
+
+# --- Escrita e Manifesto ---
+def write_file(out_dir: str, rel_path: str, chunks, profile: str, entries: list, params: dict):
+    path = os.path.join(out_dir, rel_path)
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    sha = hashlib.sha256()
+    crc = 0
+    size = 0
+    with open(path, 'wb') as f:
+        for chunk in chunks:
+            f.write(chunk)
+            sha.update(chunk)
+            crc = zlib.crc32(chunk, crc)
+            size += len(chunk)
+    entries.append({'arquivo': rel_path, 'perfil': profile, 'tamanho': size,
+                    'sha256': sha.hexdigest(), 'crc32': f"{crc:08x}", 'parametros': params})
+    print(f"[CORPUS] {rel_path} ({profile}, {size} bytes)")
+
+
+def generate(out_dir: str, seed: int, profiles: list, size: int, stream_size: int,
+             small_count: int, versions: int) -> list:
+    entries = []
+    if 'aleatorio' in profiles:
+        rng = derive_rng(seed, 'aleatorio')
+        write_file(out_dir, 'aleatorio.bin', random_chunks(rng, size), 'aleatorio', entries, {'tamanho': size})
+
+    if 'texto' in profiles:
+        rng = derive_rng(seed, 'texto')
+        write_file(out_dir, 'texto.txt', text_chunks(rng, size), 'texto', entries, {'tamanho': size})
+
+    if 'esparso' in profiles:
+        rng = derive_rng(seed, 'esparso')
+        write_file(out_dir, 'esparso.bin', sparse_chunks(rng, size), 'esparso', entries,
+                   {'tamanho': size, 'densidade': 0.02})
+
+    if 'modificado' in profiles:
+        rng = derive_rng(seed, 'modificado')
+        base = b''.join(text_chunks(random.Random(rng.getrandbits(64)), size // 2)) + rng.randbytes(size - size // 2)
+        write_file(out_dir, 'modificado/v0.bin', [base], 'modificado', entries, {'versao': 0})
+        current = base
+        for version in range(1, versions + 1):
+            edits = rng.randint(1, 16)
+            current = mutate(rng, current, edits)
+            write_file(out_dir, f"modificado/v{version}.bin", [current], 'modificado', entries,
+                       {'versao': version, 'alteracoes': edits, 'base': f"v{version - 1}.bin"})
+
+    if 'pequenos' in profiles:
+        rng = derive_rng(seed, 'pequenos')
+        template = b''.join(text_chunks(random.Random(rng.getrandbits(64)), 4096))
+        for i in range(small_count):
+            tiny = mutate(rng, template[:rng.randint(16, 512)], rng.randint(0, 3))
+            write_file(out_dir, f"pequenos/arquivo_{i:05d}.txt", [tiny], 'pequenos', entries, {'indice': i})
+
+    if 'fluxo' in profiles:
+        rng = derive_rng(seed, 'fluxo')
+        write_file(out_dir, 'fluxo.bin', mixed_chunks(rng, stream_size), 'fluxo', entries,
+                   {'tamanho': stream_size})
+    return entries
+
+
+def file_digests(path: str):
+    sha = hashlib.sha256()
+    crc = 0
+    with open(path, 'rb') as f:
+        while True:
+            chunk = f.read(CHUNK_SIZE)
+            if not chunk:
+                break
+            sha.update(chunk)
+            crc = zlib.crc32(chunk, crc)
+    return sha.hexdigest(), f"{crc:08x}"
+
+
+def verify(out_dir: str) -> bool:
+    """Confere o corpus em disco contra o próprio manifesto: detecta só alterações em disco"""
+    with open(os.path.join(out_dir, MANIFEST_NAME), 'r') as f:
+        manifest = json.load(f)
+    ok = True
+    for entry in manifest['arquivos']:
+        path = os.path.join(out_dir, entry['arquivo'])
+        if not os.path.exists(path):
+            print(f"[ERRO] Ausente: {entry['arquivo']}")
+            ok = False
+            continue
+        sha, crc = file_digests(path)
+        if sha != entry['sha256'] or crc != entry['crc32']:
+            print(f"[ERRO] Divergente: {entry['arquivo']}")
+            ok = False
+    print(f"[CORPUS] {len(manifest['arquivos'])} arquivos verificados: {'OK' if ok else 'FALHA'}.")
+    return ok
+
+
+def check_reference(write: bool) -> bool:
+    """Regenera o corpus de referência (semente padrão, tamanhos pequenos) e o compara com o versionado"""
+    with tempfile.TemporaryDirectory(prefix='corpus_referencia_') as tmp_dir:
+        entries = generate(tmp_dir, DEFAULT_SEED, PROFILES, **REFERENCE_PARAMS)
+    sums = ''.join(f"{entry['sha256']}  {entry['arquivo']}\n" for entry in entries)
+    if write:
+        with open(REFERENCE_PATH, 'w') as f:
+            f.write(sums)
+        print(f"[CORPUS] Referência gravada em '{REFERENCE_PATH}' ({len(entries)} arquivos).")
+        return True
+
+    with open(REFERENCE_PATH, 'r') as f:
+        expected = dict(line.split()[::-1] for line in f if line.strip())
+    got = {entry['arquivo']: entry['sha256'] for entry in entries}
+    diverged = sorted(name for name in expected.keys() | got.keys() if expected.get(name) != got.get(name))
+    for name in diverged:
+        print(f"[ERRO] Divergente da referência: {name}")
+    ok = not diverged
+    print(f"[CORPUS] Referência (semente {DEFAULT_SEED}, versão {GENERATOR_VERSION}): "
+          f"{len(expected)} arquivos, {'OK' if ok else 'FALHA'}.")
+    return ok
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Gera o corpus reprodutível dos benchmarks")
+    parser.add_argument('-o', '--saida', default='corpus', help="Diretório de saída")
+    parser.add_argument('-s', '--semente', type=int, default=DEFAULT_SEED)
+    parser.add_argument('--perfis', nargs='+', choices=PROFILES, default=PROFILES)
+    parser.add_argument('--tamanho', type=int, default=1024 * 1024, help="Bytes dos perfis de arquivo único")
+    parser.add_argument('--tamanho-fluxo', type=int, default=2 * 1024 ** 3, help="Bytes do fluxo longo")
+    parser.add_argument('--pequenos', type=int, default=1000, help="Quantidade de arquivos pequenos")
+    parser.add_argument('--versoes', type=int, default=5, help="Versões modificadas para testes de delta")
+    parser.add_argument('--verificar', action='store_true', help="Só confere o corpus existente contra o manifesto")
+    parser.add_argument('--referencia', action='store_true',
+                        help="Regenera o corpus pequeno de referência e o compara com corpus_referencia.sha256")
+    parser.add_argument('--gravar-referencia', action='store_true',
+                        help="Regrava corpus_referencia.sha256 (só ao mudar GENERATOR_VERSION)")
+    args = parser.parse_args()
+
+    if args.referencia or args.gravar_referencia:
+        sys.exit(0 if check_reference(args.gravar_referencia) else 1)
+
+    if args.verificar:
+        sys.exit(0 if verify(args.saida) else 1)
+
+    os.makedirs(args.saida, exist_ok=True)
+    entries = generate(args.saida, args.semente, args.perfis, args.tamanho, args.tamanho_fluxo,
+                       args.pequenos, args.versoes)
+
+    manifest = {'versao_gerador': GENERATOR_VERSION, 'semente': args.semente, 'perfis': args.perfis,
+                'arquivos': entries}
+    with open(os.path.join(args.saida, MANIFEST_NAME), 'w') as f:
+        json.dump(manifest, f, indent=2, ensure_ascii=False)
+    with open(os.path.join(args.saida, SUMS_NAME), 'w') as f:
+        for entry in entries:
+            f.write(f"{entry['sha256']}  {entry['arquivo']}\n")
+    total = sum(entry['tamanho'] for entry in entries)
+    print(f"[CORPUS] {len(entries)} arquivos, {total} bytes em '{args.saida}/' (semente {args.semente}).")
+
+
+if __name__ == "__main__":
+    main()
@@ -5,6 +5,15 @@ import argparse
 import os
 import sys
 import signal
+import zlib
+import json
+import hashlib
+import tempfile
+import queue
+import threading
+import socket
+import selectors
+import multiprocessing
 
 # --- Configurações Globais ---
 BLOCK_SIZE = 100
@@ -23,6 +32,33 @@ NAK_CHAR = b'N'
 # --- Parâmetros do Protocolo ---
 TIMEOUT_SEC = 3
 MAX_RETRANS = 5
+SEQ_MODULO = 64  # janela deslizante: seq < 64 nunca se confunde com 'S'/'E'
+MAX_WINDOW = SEQ_MODULO // 2
+RTO_MIN_SEC = 0.2
+DUP_ACK_THRESHOLD = 3
+RELAY_QUEUE_BLOCKS = 64
+SHAPER_MAX_SLEEP = 0.1
+INDEX_SUFFIX = '.idx'
+INDEX_VERSION = 3
+CDC_MIN_SIZE = 2 * 1024
+CDC_AVG_MASK = (1 << 13) - 1  # fronteira média a cada ~8 KiB
+CDC_MAX_SIZE = 64 * 1024
+FEC_LEN_SIZE = 1
+FEC_HEADER_SIZE = SEQ_SIZE + 1 + CRC_SIZE  # seq + profundidade + CRC do cabeçalho
+BATCH_SUFFIX = '.lote'
+BATCH_SEGMENT_HEADER = struct.Struct('<8sI')  # id do fluxo + tamanho comprimido
+BATCH_FILE_HEADER = struct.Struct('<HQ')  # tamanho do nome + tamanho do arquivo
+BATCH_RESET_BYTES = 256 * 1024
+BATCH_LEVEL = 9
+RS485_POLL = b'P'
+RS485_DATA = b'D'
+RS485_EOT = b'T'
+RS485_HEADER_SIZE = 4  # endereço + tipo + tamanho (2)
+RS485_REPLY_SEC = 0.2
+RS485_MAX_BATCH = 127
+GATEWAY_IDLE_SEC = 10
+GATEWAY_FRAME_SEC = 3
+GATEWAY_METRICS = ('sessoes', 'concluidas', 'blocos', 'bytes', 'naks')
 
 received_interrupt = False
 
@@ -34,26 +70,9 @@ def signal_handler(signum, frame):
 
 
 # --- CRC32 ---
-POLYNOMIAL = 0xEDB88320
-CRC_TABLE = []
-
-
-def generate_crc_table():
-    global CRC_TABLE
-    if CRC_TABLE:
-        return
-    for i in range(256):
-        crc = i
-        for _ in range(8):
-            crc = (crc >> 1) ^ POLYNOMIAL if (crc & 1) else (crc >> 1)
-        CRC_TABLE.append(crc & 0xFFFFFFFF)
-
-
 def calculate_crc32(data: bytes) -> bytes:
-    crc = 0xFFFFFFFF
-    for byte in data:
-        crc = (crc >> 8) ^ CRC_TABLE[(crc ^ byte) & 0xFF]
-    return struct.pack('<I', crc ^ 0xFFFFFFFF)
+    """CRC32 IEEE 802.3 (polinômio 0xEDB88320), calculado em C pelo zlib"""
+    return struct.pack('<I', zlib.crc32(data))
 
 
 # --- Funções Auxiliares ---
@@ -109,8 +128,746 @@ def remove_checkpoint(filename: str):
         print("[CHECKPOINT] Removido com sucesso.")
 
 
+def file_prefix_crc(file_path: str, length: int) -> int:
+    """CRC32 dos primeiros 'length' bytes do arquivo"""
+    crc = 0
+    with open(file_path, 'rb') as f:
+        while length > 0:
+            chunk = f.read(min(length, 1024 * 1024))
+            if not chunk:
+                break
+            crc = zlib.crc32(chunk, crc)
+            length -= len(chunk)
+    return crc
+
+
+def build_ack_status(last_block: int, prefix_crc: int = None) -> bytes:
+    """ACK_STATUS:<bloco>[:<crc32 do que o receptor já tem>]"""
+    text = str(last_block) if prefix_crc is None else f"{last_block}:{prefix_crc:08x}"
+    return ACK_STATUS_SIGNAL + text.encode('utf-8') + b'\n'
+
+
+def parse_ack_status(response: bytes):
+    """Devolve (bloco, crc32 do prefixo ou None); ValueError se malformado"""
+    fields = response[len(ACK_STATUS_SIGNAL):].strip().decode('utf-8').split(':')
+    return int(fields[0]), (int(fields[1], 16) if len(fields) > 1 else None)
+
+
+# --- Enlace (Quadros) ---
+def build_packet(seq: int, crc_bytes: bytes, data: bytes) -> bytes:
+    return bytes([seq]) + crc_bytes + struct.pack('<I', len(data)) + data
+
+
+def send_packet_arq(ser: serial.Serial, packet: bytes, block_label: int, timeout_sec: float = TIMEOUT_SEC) -> bool:
+    """Envia um quadro e aguarda ACK, retransmitindo em NAK/timeout"""
+    retries = 0
+    while retries < MAX_RETRANS:
+        if received_interrupt:
+            return False
+        ser.write(packet)
+        response = receive_with_timeout(ser, 1, timeout_sec)
+        if response == ACK_CHAR:
+            print(f"[ACK] Bloco {block_label} confirmado.")
+            return True
+        elif response == NAK_CHAR:
+            print(f"[NAK] Retransmitindo Bloco {block_label}.")
+        else:
+            print(f"[TIMEOUT] Sem resposta, reenviando Bloco {block_label}.")
+        retries += 1
+    return False
+
+
+def read_control_signal(ser: serial.Serial, header: bytes):
+    """
+    O número de sequência nunca vale 'S' nem 'E': START e END são inequívocos.
+    Retorna a tupla de read_frame() para um sinal de controle, ou None para quadros.
+    """
+    if header == START_TRANSMISSION_SIGNAL[:1]:
+        original_timeout = ser.timeout
+        ser.timeout = 1
+        line = header + ser.readline()
+        ser.timeout = original_timeout
+        if line.startswith(START_TRANSMISSION_SIGNAL) and line.endswith(b'\n'):
+            return 'START', None, None, line
+        return 'ERRO', None, None, None
+
+    if header == END_SIGNAL[:1]:
+        rest = receive_with_timeout(ser, len(END_SIGNAL) - 1, 1)
+        if header + rest == END_SIGNAL:
+            return 'END', None, None, None
+        return 'ERRO', None, None, None
+    return None
+
+
+def read_frame(ser: serial.Serial, idle_timeout: int = 10):
+    """
+    Lê um quadro de dados ou o sinal END.
+    Retorna (tipo, seq, crc, dados), com tipo em 'DADOS', 'START', 'END', 'TIMEOUT'
+    ou 'ERRO'. Em 'START' os dados são a linha recebida; em 'ERRO' o chamador deve
+    responder NAK.
+    """
+    header = receive_with_timeout(ser, 1, idle_timeout)
+    if not header:
+        return 'TIMEOUT', None, None, None
+
+    control = read_control_signal(ser, header)
+    if control:
+        return control
+
+    header_rest = receive_with_timeout(ser, 8, 1)
+    if len(header_rest) < 8:
+        return 'ERRO', None, None, None
+
+    seq = header[0]
+    recv_crc = header_rest[0:4]
+    data_len = struct.unpack('<I', header_rest[4:8])[0]
+    if data_len > BLOCK_SIZE:
+        ser.flushInput()
+        return 'ERRO', None, None, None
+
+    data = receive_with_timeout(ser, data_len, 2)
+    if len(data) != data_len:
+        return 'ERRO', None, None, None
+
+    if calculate_crc32(data) != recv_crc:
+        return 'ERRO', None, None, None
+    return 'DADOS', seq, recv_crc, data
+
+
+# --- Modelagem de Tráfego (Token Bucket) ---
+class TokenBucket:
+    """Limita a taxa de escrita em bytes/s, permitindo rajadas de até 'burst' bytes"""
+
+    def __init__(self, rate: float = 0, burst: int = 0):
+        self.lock = threading.Lock()
+        self.rate = 0.0
+        self.burst = 0
+        self.explicit_burst = False
+        self.tokens = 0.0
+        self.last = time.monotonic()
+        self.set_limits(rate, burst)
+        self.tokens = float(self.burst)
+
+    def set_limits(self, rate: float = None, burst: int = None):
+        with self.lock:
+            self._refill()
+            if rate is not None:
+                self.rate = max(0.0, float(rate))
+            if burst:
+                self.burst = max(1, int(burst))
+                self.explicit_burst = True
+            elif not self.explicit_burst:
+                # Rajada padrão acompanha a taxa: 100 ms de tráfego, no mínimo um quadro
+                self.burst = max(MAX_PACKET_SIZE, int(self.rate) // 10)
+            self.tokens = min(self.tokens, self.burst)
+
+    def _refill(self):
+        now = time.monotonic()
+        self.tokens = min(self.burst, self.tokens + (now - self.last) * self.rate)
+        self.last = now
+
+    def consume(self, n: int):
+        """
+        Bloqueia até haver fichas para 'n' bytes. Se a rajada for reduzida abaixo
+        de 'n' durante a espera, basta o balde cheio e o saldo fica negativo: a
+        dívida é paga pelas escritas seguintes e a taxa média se mantém.
+        """
+        while not received_interrupt:
+            with self.lock:
+                if self.rate <= 0:
+                    return
+                self._refill()
+                need = min(n, self.burst)
+                if self.tokens >= need:
+                    self.tokens -= n
+                    return
+                wait = (need - self.tokens) / self.rate
+            # Espera em fatias curtas para que ajustes em tempo real valham logo
+            time.sleep(min(wait, SHAPER_MAX_SLEEP))
+
+
+class ShapedSerial:
+    """Porta serial cujas escritas passam pelo token bucket (estágio de escrita)"""
+
+    def __init__(self, ser: serial.Serial, bucket: TokenBucket):
+        object.__setattr__(self, 'ser', ser)
+        object.__setattr__(self, 'bucket', bucket)
+
+    def write(self, data: bytes) -> int:
+        written = 0
+        while written < len(data):
+            chunk = data[written:written + self.bucket.burst]
+            self.bucket.consume(len(chunk))
+            written += self.ser.write(chunk)
+        return written
+
+    def __getattr__(self, name):
+        return getattr(self.ser, name)
+
+    def __setattr__(self, name, value):
+        setattr(self.ser, name, value)
+
+
+def rate_control_server(port: int, buckets: dict):
+    """
+    Interface de controle via UDP (127.0.0.1). Comandos:
+      taxa <canal> <bytes/s>   rajada <canal> <bytes>   status
+    """
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(('127.0.0.1', port))
+    print(f"[SHAPER] Controle de taxa em udp://127.0.0.1:{port} (canais: {', '.join(buckets)}).")
+    while True:
+        msg, addr = sock.recvfrom(512)
+        parts = msg.decode('utf-8', 'replace').split()
+        try:
+            if parts and parts[0] in ('taxa', 'rajada') and len(parts) == 3:
+                bucket = buckets[parts[1]]
+                if parts[0] == 'taxa':
+                    bucket.set_limits(rate=float(parts[2]))
+                else:
+                    bucket.set_limits(burst=int(parts[2]))
+                print(f"[SHAPER] Canal '{parts[1]}': {bucket.rate:.0f} B/s, rajada {bucket.burst} B.")
+            elif parts != ['status']:
+                raise ValueError("comando inválido")
+            reply = '\n'.join(f"{name} taxa={b.rate:.0f} rajada={b.burst}" for name, b in buckets.items())
+        except (KeyError, ValueError) as e:
+            reply = f"ERRO {e}"
+        sock.sendto(reply.encode('utf-8') + b'\n', addr)
+
+
+# --- FEC (Reed-Solomon) e Entrelaçamento ---
+# RS sobre GF(2^8), polinômio primitivo 0x11D, raízes alfa^0 .. alfa^(nsym-1).
+# Corrige até nsym/2 bytes errados por palavra-código.
+GF_EXP = [0] * 512
+GF_LOG = [0] * 256
+
+
+def generate_gf_tables():
+    x = 1
+    for i in range(255):
+        GF_EXP[i] = x
+        GF_LOG[x] = i
+        x <<= 1
+        if x & 0x100:
+            x ^= 0x11D
+    for i in range(255, 512):
+        GF_EXP[i] = GF_EXP[i - 255]
+
+
+generate_gf_tables()
+
+
+def gf_mul(x: int, y: int) -> int:
+    if x == 0 or y == 0:
+        return 0
+    return GF_EXP[GF_LOG[x] + GF_LOG[y]]
+
+
+def gf_inverse(x: int) -> int:
+    return GF_EXP[255 - GF_LOG[x]]
+
+
+def gf_pow(x: int, power: int) -> int:
+    return GF_EXP[(GF_LOG[x] * power) % 255]
+
+
+def gf_poly_scale(p: list, x: int) -> list:
+    return [gf_mul(c, x) for c in p]
+
+
+def gf_poly_add(p: list, q: list) -> list:
+    r = [0] * max(len(p), len(q))
+    for i, c in enumerate(p):
+        r[i + len(r) - len(p)] = c
+    for i, c in enumerate(q):
+        r[i + len(r) - len(q)] ^= c
+    return r
+
+
+def gf_poly_mul(p: list, q: list) -> list:
+    r = [0] * (len(p) + len(q) - 1)
+    for j, qj in enumerate(q):
+        for i, pi in enumerate(p):
+            r[i + j] ^= gf_mul(pi, qj)
+    return r
+
+
+def gf_poly_eval(poly: list, x: int) -> int:
+    y = poly[0]
+    for coef in poly[1:]:
+        y = gf_mul(y, x) ^ coef
+    return y
+
+
+def gf_poly_remainder(dividend: list, divisor: list) -> list:
+    out = list(dividend)
+    for i in range(len(dividend) - (len(divisor) - 1)):
+        coef = out[i]
+        if coef:
+            for j in range(1, len(divisor)):
+                out[i + j] ^= gf_mul(divisor[j], coef)
+    return out[-(len(divisor) - 1):]
+
+
+RS_GENERATORS = {}
+
+
+def rs_generator_poly(nsym: int) -> list:
+    if nsym not in RS_GENERATORS:
+        g = [1]
+        for i in range(nsym):
+            g = gf_poly_mul(g, [1, GF_EXP[i]])
+        RS_GENERATORS[nsym] = g
+    return RS_GENERATORS[nsym]
+
+
+def rs_encode(msg: bytes, nsym: int) -> bytes:
+    return bytes(msg) + bytes(gf_poly_remainder(list(msg) + [0] * nsym, rs_generator_poly(nsym)))
+
+
+def rs_decode(codeword: bytes, nsym: int):
+    """Devolve (mensagem, símbolos corrigidos) ou (None, 0) se irrecuperável"""
+    cw = list(codeword)
+    n = len(cw)
+    synd = [0] + [gf_poly_eval(cw, GF_EXP[i]) for i in range(nsym)]
+    if not any(synd):
+        return bytes(cw[:-nsym]), 0
+
+    # Berlekamp-Massey: polinômio localizador de erros
+    err_loc = [1]
+    old_loc = [1]
+    for i in range(nsym):
+        k = i + 1
+        delta = synd[k]
+        for j in range(1, len(err_loc)):
+            delta ^= gf_mul(err_loc[-(j + 1)], synd[k - j])
+        old_loc = old_loc + [0]
+        if delta:
+            if len(old_loc) > len(err_loc):
+                new_loc = gf_poly_scale(old_loc, delta)
+                old_loc = gf_poly_scale(err_loc, gf_inverse(delta))
+                err_loc = new_loc
+            err_loc = gf_poly_add(err_loc, gf_poly_scale(old_loc, delta))
+    while err_loc and err_loc[0] == 0:
+        err_loc.pop(0)
+    errs = len(err_loc) - 1
+    if errs * 2 > nsym:
+        return None, 0
+
+    # Chien: posições dos erros são as raízes do localizador
+    loc_rev = err_loc[::-1]
+    err_pos = [n - 1 - i for i in range(n) if gf_poly_eval(loc_rev, gf_pow(2, i)) == 0]
+    if len(err_pos) != errs:
+        return None, 0
+
+    # Forney: magnitudes dos erros
+    coef_pos = [n - 1 - pos for pos in err_pos]
+    errata_loc = [1]
+    for i in coef_pos:
+        errata_loc = gf_poly_mul(errata_loc, gf_poly_add([1], [gf_pow(2, i), 0]))
+    err_eval = gf_poly_remainder(gf_poly_mul(synd[::-1], errata_loc), [1] + [0] * (len(errata_loc)))
+    x_list = [GF_EXP[i] for i in coef_pos]
+    for i, xi in enumerate(x_list):
+        xi_inv = gf_inverse(xi)
+        loc_prime = 1
+        for j, xj in enumerate(x_list):
+            if j != i:
+                loc_prime = gf_mul(loc_prime, 1 ^ gf_mul(xi_inv, xj))
+        if loc_prime == 0:
+            return None, 0
+        y = gf_mul(xi, gf_poly_eval(err_eval, xi_inv))
+        cw[err_pos[i]] ^= gf_mul(y, gf_inverse(loc_prime))
+
+    if any(gf_poly_eval(cw, GF_EXP[i]) for i in range(nsym)):
+        return None, 0
+    return bytes(cw[:-nsym]), errs
+
+
+def fec_codeword_size(nsym: int) -> int:
+    return FEC_LEN_SIZE + BLOCK_SIZE + CRC_SIZE + nsym
+
+
+def fec_encode_group(seq: int, blocks: list, nsym: int, depth: int) -> bytes:
+    """
+    Codifica até 'depth' blocos em palavras-código RS e as entrelaça: o byte j
+    de cada palavra-código vai para posições consecutivas, de modo que uma
+    rajada na linha vira poucos erros em muitas palavras-código.
+    """
+    codewords = []
+    for i in range(depth):
+        data = blocks[i] if i < len(blocks) else b''
+        msg = bytes([len(data)]) + data.ljust(BLOCK_SIZE, b'\0') + calculate_crc32(data)
+        codewords.append(rs_encode(msg, nsym))
+    n = len(codewords[0])
+    payload = bytearray(n * depth)
+    for i, cw in enumerate(codewords):
+        payload[i::depth] = cw
+    header = bytes([seq, depth])
+    return header + calculate_crc32(header) + bytes(payload)
+
+
+def read_fec_group(ser: serial.Serial, nsym: int, depth: int, stats: dict, idle_timeout: int = 10):
+    """
+    Lê o quadro de um grupo de 'depth' palavras-código entrelaçadas (ou START/END)
+    e corrige os erros.
+    Retorna (tipo, seq, None, blocos) no formato de read_frame().
+    """
+    header = receive_with_timeout(ser, 1, idle_timeout)
+    if not header:
+        return 'TIMEOUT', None, None, None
+    control = read_control_signal(ser, header)
+    if control:
+        return control
+
+    started = time.monotonic()
+    rest = receive_with_timeout(ser, FEC_HEADER_SIZE - 1, 1)
+    group_header = header + rest
+    if (len(group_header) < FEC_HEADER_SIZE or group_header[1] != depth
+            or calculate_crc32(group_header[:2]) != group_header[2:]):
+        ser.flushInput()
+        return 'ERRO', None, None, None
+
+    n = fec_codeword_size(nsym)
+    payload = receive_with_timeout(ser, n * depth, 2 + n * depth * 10 // max(ser.baudrate, 1))
+    if len(payload) != n * depth:
+        return 'ERRO', None, None, None
+
+    blocks = []
+    for i in range(depth):
+        msg, corrected = rs_decode(payload[i::depth], nsym)
+        if msg is None:
+            stats['irrecuperaveis'] += 1
+            return 'ERRO', None, None, None
+        stats['corrigidos'] += corrected
+        data_len = msg[0]
+        data = msg[FEC_LEN_SIZE:FEC_LEN_SIZE + data_len]
+        if data_len > BLOCK_SIZE or calculate_crc32(data) != msg[FEC_LEN_SIZE + BLOCK_SIZE:]:
+            stats['irrecuperaveis'] += 1
+            return 'ERRO', None, None, None
+        if data_len:
+            blocks.append(data)
+
+    stats['grupos'] += 1
+    stats['espera_total'] += time.monotonic() - started
+    return 'DADOS', group_header[0], None, blocks
+
+
+def fec_latency_ms(nsym: int, depth: int, baud: int) -> float:
+    """Espera média extra por bloco: o grupo inteiro precisa chegar antes da decodificação"""
+    return (depth - 1) / 2 * fec_codeword_size(nsym) * 10 / max(baud, 1) * 1000
+
+
+def fec_ack_timeout(nsym: int, depth: int, baud: int) -> float:
+    """Espera pelo ACK de um grupo: TIMEOUT_SEC + tempo de linha do quadro inteiro (8N1)"""
+    return TIMEOUT_SEC + (FEC_HEADER_SIZE + fec_codeword_size(nsym) * depth) * 10 / max(baud, 1)
+
+
+def print_fec_metrics(stats: dict, nsym: int, depth: int, baud: int):
+    measured = stats['espera_total'] / stats['grupos'] * 1000 if stats['grupos'] else 0
+    print(f"[METRICAS] FEC RS(n={fec_codeword_size(nsym)}, paridade={nsym}) x entrelaçamento {depth} | "
+          f"grupos={stats['grupos']} corrigidos={stats['corrigidos']} irrecuperaveis={stats['irrecuperaveis']}")
+    print(f"[METRICAS] Latência de entrelaçamento: {fec_latency_ms(nsym, depth, baud):.1f} ms por bloco "
+          f"(teórica) | recepção do grupo: {measured:.1f} ms em média")
+
+
+# --- Índice de Blocos (Sidecar) ---
+# Cache por identidade do arquivo (dispositivo, inode, tamanho, mtime e tamanho
+# de bloco): CRC32 de cada bloco, limites de chunk definidos pelo conteúdo (CDC,
+# gear hash) e SHA-256 de cada chunk, para deduplicação/delta. Gerar o CDC custa
+# ~0,3 s/MiB em Python, então o índice é calculado uma vez, em segundo plano
+# durante o primeiro envio, e reutilizado enquanto a identidade não mudar. O
+# CRC de cada quadro continua sendo calculado na hora e conferido com o cache.
+GEAR_TABLE = [int.from_bytes(hashlib.sha256(bytes([i])).digest()[:8], 'little') for i in range(256)]
+
+
+def file_identity(file_path: str) -> dict:
+    st = os.stat(file_path)
+    return {'dev': st.st_dev, 'ino': st.st_ino, 'size': st.st_size,
+            'mtime_ns': st.st_mtime_ns, 'block_size': BLOCK_SIZE}
+
+
+def build_block_index(file_path: str) -> dict:
+    """Lê o arquivo uma vez: CRC de cada bloco, limites CDC (gear hash) e SHA-256 de cada chunk"""
+    identity = file_identity(file_path)
+    crcs = bytearray()
+    boundaries = []
+    chunk_hashes = []
+    chunk_hash = hashlib.sha256()
+    chunk_len = 0
+    gear = 0
+    offset = 0
+    mask64 = 0xFFFFFFFFFFFFFFFF
+
+    with open(file_path, 'rb') as f:
+        while True:
+            buffer = f.read(BLOCK_SIZE * 1024)
+            if not buffer:
+                break
+            for i in range(0, len(buffer), BLOCK_SIZE):
+                crcs += calculate_crc32(buffer[i:i + BLOCK_SIZE])
+
+            start = 0
+            for i, byte in enumerate(buffer):
+                gear = ((gear << 1) + GEAR_TABLE[byte]) & mask64
+                chunk_len += 1
+                if (chunk_len >= CDC_MIN_SIZE and (gear & CDC_AVG_MASK) == 0) or chunk_len >= CDC_MAX_SIZE:
+                    chunk_hash.update(buffer[start:i + 1])
+                    boundaries.append(offset + i + 1)
+                    chunk_hashes.append(chunk_hash.hexdigest())
+                    chunk_hash = hashlib.sha256()
+                    chunk_len = 0
+                    gear = 0
+                    start = i + 1
+            chunk_hash.update(buffer[start:])
+            offset += len(buffer)
+
+    if chunk_len:
+        boundaries.append(offset)
+        chunk_hashes.append(chunk_hash.hexdigest())
+
+    return {
+        'versao': INDEX_VERSION,
+        'identidade': identity,
+        'crc32': crcs.hex(),
+        'cdc': {'min': CDC_MIN_SIZE, 'mascara': CDC_AVG_MASK, 'max': CDC_MAX_SIZE,
+                'limites': boundaries, 'sha256': chunk_hashes},
+    }
+
+
+def load_block_index(file_path: str):
+    """Devolve o índice salvo se ainda descreve o arquivo (mesma identidade); senão None"""
+    try:
+        with open(file_path + INDEX_SUFFIX, 'r') as f:
+            index = json.load(f)
+        if (index.get('versao') != INDEX_VERSION or index.get('identidade') != file_identity(file_path)
+                or index['cdc'].get('mascara') != CDC_AVG_MASK):
+            return None
+        return index
+    except Exception:
+        return None
+
+
+def save_block_index(file_path: str):
+    """Gera e grava o índice (troca atômica); descarta se o arquivo mudou durante a leitura"""
+    started = time.monotonic()
+    index = build_block_index(file_path)
+    if index['identidade'] != file_identity(file_path):
+        print(f"[INDICE] '{file_path}' mudou durante a geração do índice; não foi salvo.")
+        return
+    try:
+        tmp_path = file_path + INDEX_SUFFIX + '.tmp'
+        with open(tmp_path, 'w') as f:
+            json.dump(index, f)
+        os.replace(tmp_path, file_path + INDEX_SUFFIX)
+        print(f"[INDICE] Índice de '{file_path}' gravado ({len(index['cdc']['limites'])} chunks, "
+              f"{time.monotonic() - started:.2f} s).")
+    except Exception as e:
+        print(f"[AVISO] Índice não foi salvo: {e}", file=sys.stderr)
+
+
+class BlockIndexCache:
+    """
+    Índice em uso pelo emissor. Reutiliza o sidecar válido; sem ele, gera um
+    novo em segundo plano enquanto os quadros já seguem com CRC calculado na hora.
+    """
+
+    def __init__(self, file_path: str):
+        self.file_path = file_path
+        self.builder = None
+        self.index = load_block_index(file_path)
+        if self.index is not None:
+            print(f"[INDICE] Reutilizando '{file_path}{INDEX_SUFFIX}' (sem recálculo de CDC/SHA-256).")
+        else:
+            self.rebuild()
+
+    def rebuild(self):
+        self.index = None
+        if self.builder is not None and self.builder.is_alive():
+            return
+        print(f"[INDICE] Calculando índice de '{self.file_path}' em segundo plano...")
+        self.builder = threading.Thread(target=save_block_index, args=(self.file_path,), daemon=True)
+        self.builder.start()
+
+    def frame_crc(self, block: int, data: bytes) -> bytes:
+        """CRC do quadro, calculado na hora e conferido com o cache"""
+        crc_bytes = calculate_crc32(data)
+        if self.index is not None and bytes.fromhex(self.index['crc32'][block * 8:(block + 1) * 8]) != crc_bytes:
+            # Mesma identidade, conteúdo diferente (reescrita preservando o mtime)
+            print(f"[INDICE] Bloco {block + 1} difere do índice: descartando e recalculando.")
+            try:
+                os.remove(self.file_path + INDEX_SUFFIX)
+            except OSError:
+                pass
+            self.rebuild()
+        return crc_bytes
+
+    def finish(self):
+        if self.builder is not None and self.builder.is_alive() and not received_interrupt:
+            print("[INDICE] Aguardando o término do índice...")
+            self.builder.join()
+
+
+# --- Janela Deslizante (Go-Back-N com AIMD) ---
+class AimdWindow:
+    """
+    Controle de congestionamento no estilo TCP: slow start até ssthresh,
+    depois +1 quadro por janela confirmada (aditivo); perda por NAK ou ACKs
+    duplicados divide a janela por 2 e timeout volta a 1 (multiplicativo).
+    O RTO segue a estimativa de Jacobson/Karn.
+    """
+
+    def __init__(self, max_window: int):
+        self.max_window = max_window
+        self.cwnd = 1.0
+        self.ssthresh = float(max_window)
+        self.srtt = None
+        self.rttvar = 0.0
+        self.rto = float(TIMEOUT_SEC)
+        self.peak = 1.0
+        self.losses = 0
+        self.timeouts = 0
+
+    def size(self) -> int:
+        return max(1, min(self.max_window, int(self.cwnd)))
+
+    def on_ack(self, acked: int):
+        for _ in range(acked):
+            if self.cwnd < self.ssthresh:
+                self.cwnd += 1
+            else:
+                self.cwnd += 1 / self.cwnd
+        self.cwnd = min(self.cwnd, self.max_window)
+        self.peak = max(self.peak, self.cwnd)
+
+    def on_loss(self):
+        self.losses += 1
+        self.ssthresh = max(self.cwnd / 2, 1.0)
+        self.cwnd = self.ssthresh
+
+    def on_timeout(self):
+        self.timeouts += 1
+        self.ssthresh = max(self.cwnd / 2, 1.0)
+        self.cwnd = 1.0
+        self.rto = min(self.rto * 2, TIMEOUT_SEC * 4)
+
+    def on_rtt_sample(self, rtt: float):
+        if self.srtt is None:
+            self.srtt = rtt
+            self.rttvar = rtt / 2
+        else:
+            self.rttvar = 0.75 * self.rttvar + 0.25 * abs(self.srtt - rtt)
+            self.srtt = 0.875 * self.srtt + 0.125 * rtt
+        self.rto = min(max(self.srtt + 4 * self.rttvar, RTO_MIN_SEC), float(TIMEOUT_SEC))
+
+
+def read_window_reply(ser: serial.Serial, timeout_sec: float):
+    """Lê um ACK/NAK de janela (sinal + seq). Retorna (sinal, seq) ou (None, None)"""
+    deadline = time.time() + timeout_sec
+    while not received_interrupt:
+        remaining = deadline - time.time()
+        if remaining <= 0:
+            return None, None
+        kind = receive_with_timeout(ser, 1, remaining)
+        if kind in (ACK_CHAR, NAK_CHAR):
+            seq = receive_with_timeout(ser, 1, 1)
+            if len(seq) == 1 and seq[0] < SEQ_MODULO:
+                return kind, seq[0]
+    return None, None
+
+
+def send_window_aimd(ser: serial.Serial, f_in, first_block: int, total_blocks: int,
+                     max_window: int, frame_crc=None) -> int:
+    """
+    Envia os blocos com até 'cwnd' quadros em voo (Go-Back-N, ACK cumulativo).
+    Devolve o primeiro bloco ainda não confirmado.
+    """
+    window = AimdWindow(max_window)
+    base = first_block
+    next_block = first_block
+    in_flight = {}  # bloco -> [pacote, instante do envio, retransmitido]
+    dup_acks = 0
+    recovery_until = first_block
+    retries = 0
+
+    def send(block: int, retransmission: bool):
+        if block not in in_flight:
+            f_in.seek(block * BLOCK_SIZE)
+            data = f_in.read(BLOCK_SIZE)
+            crc_bytes = frame_crc(block, data) if frame_crc else calculate_crc32(data)
+            in_flight[block] = [build_packet(block % SEQ_MODULO, crc_bytes, data), 0.0, False]
+        entry = in_flight[block]
+        entry[1] = time.monotonic()
+        entry[2] = entry[2] or retransmission
+        ser.write(entry[0])
+
+    def go_back():
+        nonlocal next_block, recovery_until
+        recovery_until = next_block
+        next_block = base
+
+    while base < total_blocks and not received_interrupt:
+        while next_block < total_blocks and next_block - base < window.size():
+            send(next_block, next_block < recovery_until)
+            next_block += 1
+
+        oldest_sent = in_flight[base][1]
+        wait = max(0.0, oldest_sent + window.rto - time.monotonic())
+        kind, seq = read_window_reply(ser, wait)
+
+        if kind is None:
+            if received_interrupt:
+                break
+            retries += 1
+            print(f"[TIMEOUT] Bloco {base + 1} sem ACK (RTO {window.rto:.2f} s). "
+                  f"Janela {window.cwnd:.1f} -> 1.")
+            if retries >= MAX_RETRANS:
+                print(f"[ERRO] Falha no Bloco {base + 1}. Abortando.")
+                break
+            window.on_timeout()
+            dup_acks = 0
+            go_back()
+            continue
+
+        # Converte o seq (módulo 64) no bloco correspondente. Depois de um go-back,
+        # o ACK cumulativo pode cobrir blocos enviados antes dele (até recovery_until)
+        offset = (seq - base) % SEQ_MODULO
+        highest_sent = max(next_block, recovery_until)
+        if kind == ACK_CHAR and offset < highest_sent - base:
+            acked_block = base + offset
+            entry = in_flight[acked_block]
+            if not entry[2]:
+                window.on_rtt_sample(time.monotonic() - entry[1])
+            acked = acked_block + 1 - base
+            for block in range(base, acked_block + 1):
+                in_flight.pop(block, None)
+            base = acked_block + 1
+            next_block = max(next_block, base)
+            retries = 0
+            dup_acks = 0
+            window.on_ack(acked)
+            print(f"[ACK] Bloco {base} confirmado. Janela {window.cwnd:.1f}.")
+            continue
+
+        # ACK duplicado (último bloco em ordem) ou NAK do bloco esperado: perda
+        if kind == ACK_CHAR:
+            dup_acks += 1
+            if dup_acks < DUP_ACK_THRESHOLD:
+                continue
+        dup_acks = 0
+        if base >= recovery_until:
+            window.on_loss()
+            print(f"[NAK] Perda no Bloco {base + 1}. Janela reduzida para {window.cwnd:.1f}.")
+            go_back()
+
+    srtt_ms = (window.srtt or 0) * 1000
+    print(f"[METRICAS] Janela AIMD | pico={window.peak:.1f} final={window.cwnd:.1f} "
+          f"perdas={window.losses} timeouts={window.timeouts} srtt={srtt_ms:.1f} ms rto={window.rto:.2f} s")
+    return base
+
+
 # --- Emissor ---
-def emissor_handler(ser: serial.Serial, file_path: str):
+def emissor_handler(ser: serial.Serial, file_path: str, use_index: bool = False, fec: tuple = None,
+                    max_window: int = 1):
     global received_interrupt
     try:
         file_size = os.path.getsize(file_path)
@@ -122,6 +879,7 @@ def emissor_handler(ser: serial.Serial, file_path: str):
         print(f"[PROTO] Enviando solicitação de STATUS/START para '{file_path}'...")
 
         current_block = 0
+        receiver_crc = None
         retries = 0
         while retries < MAX_RETRANS:
             if received_interrupt:
@@ -130,8 +888,7 @@ def emissor_handler(ser: serial.Serial, file_path: str):
             response = receive_with_timeout(ser, MAX_FILENAME_LEN, TIMEOUT_SEC)
             if response and response.startswith(ACK_STATUS_SIGNAL):
                 try:
-                    blk = int(response[len(ACK_STATUS_SIGNAL):].strip().decode('utf-8'))
-                    current_block = blk
+                    current_block, receiver_crc = parse_ack_status(response)
                     print(f"[PROTO] Recebido ACK de STATUS. Retomando do Bloco {current_block}.")
                     break
                 except Exception:
@@ -141,43 +898,62 @@ def emissor_handler(ser: serial.Serial, file_path: str):
         if retries >= MAX_RETRANS:
             print("[ERRO] Máximo de retentativas atingido. Abortando.")
             return
+        # O receptor informa o CRC do que já tem: retomar sobre outra versão do
+        # arquivo juntaria as duas sem que nenhum CRC de bloco acusasse
+        if current_block and receiver_crc is not None:
+            prefix = current_block * BLOCK_SIZE
+            if prefix > file_size or file_prefix_crc(file_path, prefix) != receiver_crc:
+                print(f"[ERRO] Os {current_block} blocos que o receptor já tem não são deste '{file_path}'. "
+                      f"Apague o checkpoint '.temp' do receptor para reenviar do início.")
+                return
+            print(f"[PROTO] Blocos 0..{current_block - 1} do receptor conferem com o arquivo.")
+        index = BlockIndexCache(file_path) if use_index else None
+        frame_crc = index.frame_crc if index else (lambda block, data: calculate_crc32(data))
 
         # Envio dos dados
         current_block_to_send = current_block
-        current_seq_num = current_block % 2
+        # Com FEC a sequência é por grupo e recomeça em 0 a cada handshake
+        current_seq_num = 0 if fec else current_block % 2
+        if fec:
+            nsym, depth = fec
+            fec_timeout = fec_ack_timeout(nsym, depth, ser.baudrate)
+            print(f"[FEC] {nsym} símbolos de paridade, entrelaçamento {depth} "
+                  f"(+{fec_latency_ms(nsym, depth, ser.baudrate):.1f} ms por bloco, ACK em até {fec_timeout:.1f} s).")
 
         with open(file_path, 'rb') as f_in:
             f_in.seek(current_block * BLOCK_SIZE)
-            print("[PROTO] Transferência Stop-and-Wait iniciada.")
+            if max_window > 1:
+                print(f"[PROTO] Transferência com janela deslizante AIMD (máx {max_window}) iniciada.")
+                current_block_to_send = send_window_aimd(ser, f_in, current_block, total_blocks,
+                                                         max_window, frame_crc)
+            else:
+                print("[PROTO] Transferência Stop-and-Wait iniciada.")
 
-            while current_block_to_send <= total_blocks - 1:
+            while current_block_to_send <= total_blocks - 1 and max_window == 1:
                 if received_interrupt:
                     print("\n-- INTERRUPÇÃO RECEBIDA --")
                     break
 
+                if fec:
+                    blocks = [f_in.read(BLOCK_SIZE) for _ in range(depth)]
+                    blocks = [block for block in blocks if block]
+                    if not blocks:
+                        break
+                    packet = fec_encode_group(current_seq_num, blocks, nsym, depth)
+                    if not send_packet_arq(ser, packet, current_block_to_send + len(blocks), fec_timeout):
+                        print(f"[ERRO] Falha no grupo até o Bloco {current_block_to_send + len(blocks)}. Abortando.")
+                        break
+                    current_block_to_send += len(blocks)
+                    current_seq_num = 1 - current_seq_num
+                    continue
+
                 data_buffer = f_in.read(BLOCK_SIZE)
                 if not data_buffer:
                     break
 
-                data_len = len(data_buffer)
-                crc_bytes = calculate_crc32(data_buffer)
-                packet = bytes([current_seq_num]) + crc_bytes + struct.pack('<I', data_len) + data_buffer
-
-                retries = 0
-                ack_ok = False
-                while retries < MAX_RETRANS and not ack_ok:
-                    ser.write(packet)
-                    response = receive_with_timeout(ser, 1, TIMEOUT_SEC)
-                    if response == ACK_CHAR:
-                        print(f"[ACK] Bloco {current_block_to_send + 1} confirmado.")
-                        ack_ok = True
-                    elif response == NAK_CHAR:
-                        print(f"[NAK] Retransmitindo Bloco {current_block_to_send + 1}.")
-                        retries += 1
-                    else:
-                        retries += 1
-                        print(f"[TIMEOUT] Sem resposta, reenviando Bloco {current_block_to_send + 1}.")
+                packet = build_packet(current_seq_num, frame_crc(current_block_to_send, data_buffer), data_buffer)
 
+                ack_ok = send_packet_arq(ser, packet, current_block_to_send + 1)
                 if not ack_ok:
                     print(f"[ERRO] Falha no Bloco {current_block_to_send + 1}. Abortando.")
                     break
@@ -188,6 +964,8 @@ def emissor_handler(ser: serial.Serial, file_path: str):
         if current_block_to_send >= total_blocks and not received_interrupt:
             print("[PROTO] Transferência concluída. Enviando END.")
             ser.write(END_SIGNAL)
+        if index:
+            index.finish()
 
     except Exception as e:
         print(f"[ERRO] {e}", file=sys.stderr)
@@ -198,126 +976,953 @@ def emissor_handler(ser: serial.Serial, file_path: str):
 
 
 # --- Receptor ---
-def receptor_handler(ser: serial.Serial):
+def wait_for_start(ser: serial.Serial, timeout_sec: int) -> bytes:
+    """Aguarda uma linha START, descartando restos de quadros de uma sessão anterior"""
+    deadline = time.time() + timeout_sec
+    while not received_interrupt:
+        remaining = deadline - time.time()
+        if remaining <= 0:
+            return b''
+        ser.timeout = min(remaining, 1)
+        line = ser.readline()
+        if line.startswith(START_TRANSMISSION_SIGNAL) and line.endswith(b'\n'):
+            return line
+    return b''
+
+
+def open_output_file(output_file_path: str):
+    """
+    Abre o arquivo de saída alinhado ao checkpoint. Um bloco gravado sem
+    checkpoint (processo morto entre os dois passos) é descartado e pedido de novo.
+    """
+    last_block = load_checkpoint(output_file_path)
+    if last_block <= 0 or not os.path.exists(output_file_path):
+        return open(output_file_path, 'wb'), 0
+
+    file_size = os.path.getsize(output_file_path)
+    if file_size < last_block * BLOCK_SIZE:
+        last_block = file_size // BLOCK_SIZE
+    f_out = open(output_file_path, 'r+b')
+    f_out.truncate(last_block * BLOCK_SIZE)
+    f_out.seek(0, os.SEEK_END)
+    return f_out, last_block
+
+
+def receptor_handler(ser: serial.Serial, fec: tuple = None, window: bool = False, batch: bool = False):
     global received_interrupt
     try:
         print("RECEPTOR | Aguardando solicitação de STATUS do arquivo (máx 30 seg)...")
 
-        ser.timeout = 30
-        status_signal_received = ser.readline()
+        status_signal_received = wait_for_start(ser, 30)
         if not status_signal_received:
             print("[TIMEOUT] Timeout ao aguardar STATUS.")
             return
 
-        ser.flushInput()
-        ser.flushOutput()
+        # Um START no meio da sessão (emissor reiniciado) refaz o handshake
+        while status_signal_received:
+            ser.flushInput()
+            ser.flushOutput()
 
-        if not status_signal_received.startswith(START_TRANSMISSION_SIGNAL):
-            print(f"[ERRO] Sinal inválido: {status_signal_received}")
-            return
+            file_name = status_signal_received[len(START_TRANSMISSION_SIGNAL):].strip().decode('utf-8')
+            status_signal_received = b''
+            base_name = os.path.basename(file_name)
+            output_file_path = f"recebido_{base_name}"
+            print(f"[PROTO] Recebido sinal de STATUS do arquivo '{file_name}'. Será salvo como '{output_file_path}'.")
+
+            if batch:
+                batch_receiver = BatchReceiver(output_file_path)
+                last_block_received = batch_receiver.first_block
+            else:
+                f_out, last_block_received = open_output_file(output_file_path)
+
+            if batch:
+                # O fluxo do lote é conferido pelo id gravado no checkpoint
+                ack_status = build_ack_status(last_block_received)
+            else:
+                ack_status = build_ack_status(last_block_received, file_prefix_crc(
+                    output_file_path, last_block_received * BLOCK_SIZE))
+            ser.write(ack_status)
+            print(f"[PROTO] Enviando ACK_STATUS (Retomar do Bloco {last_block_received}).")
+
+            if window:
+                expected_seq_num = last_block_received % SEQ_MODULO
+            else:
+                expected_seq_num = 0 if fec else last_block_received % 2
+            current_block = last_block_received
+            fec_stats = {'grupos': 0, 'corrigidos': 0, 'irrecuperaveis': 0, 'espera_total': 0.0}
+
+            end_received = False
+            while True:
+                if fec:
+                    kind, seq, _, data = read_fec_group(ser, fec[0], fec[1], fec_stats)
+                else:
+                    kind, seq, _, data = read_frame(ser)
+                if kind == 'TIMEOUT':
+                    print("[AVISO] Timeout de leitura. Encerrando recepção.")
+                    break
+                if kind == 'END':
+                    end_received = True
+                    break
+                if kind == 'START':
+                    print("[PROTO] Novo START recebido. Refazendo handshake.")
+                    status_signal_received = data
+                    break
+                if kind == 'ERRO':
+                    ser.write(NAK_CHAR + bytes([expected_seq_num]) if window else NAK_CHAR)
+                    continue
 
-        file_name = status_signal_received[len(START_TRANSMISSION_SIGNAL):].strip().decode('utf-8')
-        base_name = os.path.basename(file_name)
-        output_file_path = f"recebido_{base_name}"
-        print(f"[PROTO] Recebido sinal de STATUS do arquivo '{file_name}'. Será salvo como '{output_file_path}'.")
+                if window and seq != expected_seq_num:
+                    # Go-Back-N: fora de ordem é descartado e o último bloco em ordem é reconfirmado
+                    ser.write(ACK_CHAR + bytes([(expected_seq_num - 1) % SEQ_MODULO]))
+                    continue
 
-        last_block_received = load_checkpoint(output_file_path)
-        mode = 'ab' if last_block_received > 0 else 'wb'
-        f_out = open(output_file_path, mode)
+                if seq != expected_seq_num:
+                    if seq == (1 - expected_seq_num):
+                        ser.write(ACK_CHAR)
+                        continue
+                    else:
+                        ser.write(NAK_CHAR)
+                        continue
 
-        ack_status = ACK_STATUS_SIGNAL + str(last_block_received).encode('utf-8') + b'\n'
-        ser.write(ack_status)
-        print(f"[PROTO] Enviando ACK_STATUS (Retomar do Bloco {last_block_received}).")
+                blocks = data if fec else [data]
+                if batch:
+                    for block in blocks:
+                        batch_receiver.add_block(block)
+                else:
+                    f_out.write(b''.join(blocks))
+                    f_out.flush()
+                if window:
+                    ser.write(ACK_CHAR + bytes([seq]))
+                    expected_seq_num = (expected_seq_num + 1) % SEQ_MODULO
+                else:
+                    ser.write(ACK_CHAR)
+                    expected_seq_num = 1 - expected_seq_num
+                current_block += len(blocks)
+                if not batch:
+                    save_checkpoint(output_file_path, current_block)
+                print(f"[RECEPTOR] Bloco {current_block} OK. Enviando ACK.")
 
-        expected_seq_num = last_block_received % 2
-        current_block = last_block_received
+            if batch:
+                batch_receiver.close(end_received)
+            else:
+                f_out.close()
+            if fec:
+                print_fec_metrics(fec_stats, fec[0], fec[1], ser.baudrate)
+            if end_received:
+                print("[PROTO] Sinal END recebido. Transferência concluída.")
+                remove_checkpoint(output_file_path)
+            elif not status_signal_received:
+                print(f"[CHECKPOINT] Mantido em {current_block} blocos para retomada.")
 
-        while True:
-            # leitura robusta
-            header = receive_with_timeout(ser, 1, 10)
-            if not header:
-                print("[AVISO] Timeout de leitura. Encerrando recepção.")
+    except Exception as e:
+        print(f"[ERRO] {e}", file=sys.stderr)
+    finally:
+        if ser.is_open:
+            ser.close()
+            print("Porta serial fechada.")
+
+
+# --- Retransmissor (Relay) ---
+def relay_downstream_worker(ser_out: serial.Serial, blocks: queue.Queue, first_block: int, state: dict):
+    """Encaminha para o próximo enlace os blocos já aceitos no enlace de entrada"""
+    current_block = first_block
+    seq = first_block % 2
+    while True:
+        item = blocks.get()
+        if item is None:
+            print("[RELAY] Encaminhando END para o próximo enlace.")
+            ser_out.write(END_SIGNAL)
+            state['done'] = True
+            return
+        if item is False:
+            return
+        crc_bytes, data = item
+        # Mantém o CRC da origem: a integridade é verificada de ponta a ponta
+        packet = build_packet(seq, crc_bytes, data)
+        if not send_packet_arq(ser_out, packet, current_block + 1):
+            print(f"[ERRO] Enlace de saída falhou no Bloco {current_block + 1}.")
+            state['failed'] = True
+            return
+        current_block += 1
+        seq = 1 - seq
+
+
+def relay_handler(ser_in: serial.Serial, ser_out: serial.Serial):
+    """
+    Termina o protocolo no enlace de entrada e encaminha cada bloco para o
+    enlace de saída assim que chega (cut-through), com ARQ próprio por salto.
+    """
+    global received_interrupt
+    blocks = queue.Queue(maxsize=RELAY_QUEUE_BLOCKS)
+    state = {'done': False, 'failed': False}
+    try:
+        print("RELAY | Aguardando solicitação de STATUS do arquivo (máx 30 seg)...")
+        status_signal_received = wait_for_start(ser_in, 30)
+        if not status_signal_received:
+            print("[TIMEOUT] Timeout ao aguardar STATUS.")
+            return
+        ser_in.flushInput()
+
+        # O checkpoint pertence ao destino final: o STATUS atravessa o relay
+        print("[RELAY] Repassando STATUS para o próximo enlace...")
+        ack_status = b''
+        retries = 0
+        ser_out.timeout = TIMEOUT_SEC
+        while retries < MAX_RETRANS and not received_interrupt:
+            ser_out.write(status_signal_received)
+            response = ser_out.readline()
+            if response.startswith(ACK_STATUS_SIGNAL):
+                ack_status = response
                 break
+            retries += 1
+            print(f"[TIMEOUT] Timeout ({retries}/{MAX_RETRANS}) no enlace de saída.")
+        if not ack_status.startswith(ACK_STATUS_SIGNAL):
+            print("[ERRO] Destino não respondeu ao STATUS. Abortando.")
+            return
 
-            header_rest = receive_with_timeout(ser, 8, 1)
-            if len(header_rest) < 8:
-                ser.write(NAK_CHAR)
-                continue
+        first_block, _ = parse_ack_status(ack_status)
+        ser_in.write(ack_status)
+        print(f"[RELAY] ACK_STATUS repassado (Retomar do Bloco {first_block}).")
 
-            seq = header[0]
-            recv_crc = header_rest[0:4]
-            data_len = struct.unpack('<I', header_rest[4:8])[0]
+        worker = threading.Thread(target=relay_downstream_worker,
+                                  args=(ser_out, blocks, first_block, state), daemon=True)
+        worker.start()
 
-            data = receive_with_timeout(ser, data_len, 2)
-            if len(data) != data_len:
-                ser.write(NAK_CHAR)
-                continue
+        def enqueue(item, hold: float = None) -> bool:
+            deadline = None if hold is None else time.monotonic() + hold
+            while not state['failed']:
+                wait = 1 if deadline is None else min(1, deadline - time.monotonic())
+                if wait <= 0:
+                    return False
+                try:
+                    blocks.put(item, timeout=wait)
+                    return True
+                except queue.Full:
+                    continue
+            return False
 
-            calc_crc = calculate_crc32(data)
-            if calc_crc != recv_crc:
-                ser.write(NAK_CHAR)
+        expected_seq_num = first_block % 2
+        current_block = first_block
+        end_received = False
+        while not state['failed']:
+            kind, seq, crc_bytes, data = read_frame(ser_in)
+            if kind == 'TIMEOUT':
+                print("[AVISO] Timeout de leitura no enlace de entrada.")
+                break
+            if kind == 'END':
+                end_received = True
+                break
+            if kind in ('ERRO', 'START'):
+                ser_in.write(NAK_CHAR)
                 continue
 
             if seq != expected_seq_num:
-                if seq == (1 - expected_seq_num):
-                    ser.write(ACK_CHAR)
-                    continue
-                else:
-                    ser.write(NAK_CHAR)
-                    continue
+                ser_in.write(ACK_CHAR if seq == (1 - expected_seq_num) else NAK_CHAR)
+                continue
 
-            f_out.write(data)
-            f_out.flush()
-            ser.write(ACK_CHAR)
+            # Fila cheia segura o ACK: o enlace mais lento dita o ritmo. O ACK não
+            # pode chegar depois do timeout da origem (seria creditado ao bloco
+            # seguinte), então o bloco é descartado sem ACK e a origem retransmite.
+            if not enqueue((crc_bytes, data), TIMEOUT_SEC / 2):
+                if state['failed']:
+                    break
+                print(f"[RELAY] Fila cheia: Bloco {current_block + 1} descartado, aguardando retransmissão.")
+                continue
+            ser_in.write(ACK_CHAR)
             expected_seq_num = 1 - expected_seq_num
             current_block += 1
-            save_checkpoint(output_file_path, current_block)
-            print(f"[RECEPTOR] Bloco {current_block} OK. Enviando ACK.")
+            print(f"[RELAY] Bloco {current_block} aceito e enfileirado.")
 
-        f_out.close()
-        print("[PROTO] Sinal END recebido. Transferência concluída.")
-        remove_checkpoint(output_file_path)
+        # Blocos já confirmados na entrada ainda seguem para o destino
+        enqueue(None if end_received else False)
+        worker.join()
+        if state['done']:
+            print("[PROTO] Transferência encaminhada até o destino.")
 
     except Exception as e:
         print(f"[ERRO] {e}", file=sys.stderr)
     finally:
-        if ser.is_open:
-            ser.close()
-            print("Porta serial fechada.")
+        for ser in (ser_in, ser_out):
+            if ser.is_open:
+                ser.close()
+        print("Portas seriais fechadas.")
+
+
+# --- Lote Comprimido (Por Arquivo ou Sólido) ---
+# Vários arquivos viram um único fluxo: para cada arquivo, cabeçalho
+# (nome, tamanho) + conteúdo. O fluxo é comprimido em segmentos independentes
+# [id do fluxo][tamanho][zlib]. No modo 'arquivo' cada arquivo é um segmento;
+# no modo 'solido' o mesmo contexto atravessa os arquivos e só é reiniciado a
+# cada 'reset_bytes', que limita o que precisa ser reenviado após interrupção.
+# O fluxo é determinístico, então o emissor o regenera igual ao retomar.
+
+def batch_stream_id(file_paths: list, mode: str, reset_bytes: int) -> bytes:
+    h = hashlib.sha256(f"{mode}:{reset_bytes}:{BATCH_LEVEL}".encode('utf-8'))
+    for path in file_paths:
+        st = os.stat(path)
+        h.update(f"{os.path.basename(path)}:{st.st_size}:{st.st_mtime_ns}".encode('utf-8'))
+    return h.digest()[:8]
+
+
+def build_batch_stream(file_paths: list, mode: str, reset_bytes: int, out_path: str) -> int:
+    """Grava o fluxo comprimido do lote em 'out_path' e devolve o total de bytes originais"""
+    stream_id = batch_stream_id(file_paths, mode, reset_bytes)
+    total_in = 0
+    segments = 0
+
+    with open(out_path, 'wb') as out:
+        state = {'comp': zlib.compressobj(BATCH_LEVEL), 'parts': [], 'fed': 0}
+
+        def flush_segment():
+            nonlocal segments
+            if not state['fed']:
+                return
+            state['parts'].append(state['comp'].flush())
+            data = b''.join(state['parts'])
+            out.write(BATCH_SEGMENT_HEADER.pack(stream_id, len(data)) + data)
+            segments += 1
+            state.update(comp=zlib.compressobj(BATCH_LEVEL), parts=[], fed=0)
+
+        def feed(data: bytes):
+            while data:
+                room = reset_bytes - state['fed'] if mode == 'solido' else len(data)
+                piece, data = data[:room], data[room:]
+                state['parts'].append(state['comp'].compress(piece))
+                state['fed'] += len(piece)
+                if mode == 'solido' and state['fed'] >= reset_bytes:
+                    flush_segment()
+
+        for path in file_paths:
+            name = os.path.basename(path).encode('utf-8')
+            size = os.path.getsize(path)
+            feed(BATCH_FILE_HEADER.pack(len(name), size) + name)
+            with open(path, 'rb') as f:
+                while True:
+                    chunk = f.read(64 * 1024)
+                    if not chunk:
+                        break
+                    feed(chunk)
+            total_in += size
+            if mode == 'arquivo':
+                flush_segment()
+        flush_segment()
+
+    wire = os.path.getsize(out_path)
+    print(f"[LOTE] {len(file_paths)} arquivos, {total_in} bytes -> {wire} bytes comprimidos "
+          f"({mode}, {segments} segmentos, {wire / max(total_in, 1) * 100:.1f}%).")
+    return total_in
+
+
+class BatchReceiver:
+    """
+    Recebe o fluxo do lote bloco a bloco, descomprime cada segmento completo no
+    arquivo '<saida>' e só avança o checkpoint em fronteiras de segmento.
+    Checkpoint: 'bytes do fluxo consumidos, bytes descomprimidos, id do fluxo'.
+    """
+
+    def __init__(self, output_file_path: str):
+        self.output_file_path = output_file_path
+        self.stream_off, self.archive_len, self.stream_id = self.load()
+        # Como em open_output_file(): o checkpoint só vale se o arquivo em disco
+        # tem pelo menos o que ele registra. Segmento gravado sem checkpoint é
+        # cortado; arquivo ausente ou menor obriga a recomeçar o fluxo do zero.
+        archive_size = os.path.getsize(output_file_path) if os.path.exists(output_file_path) else -1
+        if self.stream_off and archive_size < self.archive_len:
+            print(f"[LOTE] '{output_file_path}' ausente ou menor que o checkpoint. Recomeçando o lote.")
+            self.stream_off, self.archive_len, self.stream_id = 0, 0, None
+        self.pending = bytearray()
+        self.skip = self.stream_off % BLOCK_SIZE
+        self.first_block = self.stream_off // BLOCK_SIZE
+        mode = 'r+b' if self.stream_off else 'wb'
+        self.f_out = open(output_file_path, mode)
+        self.f_out.truncate(self.archive_len)
+        self.f_out.seek(0, os.SEEK_END)
+
+    def load(self):
+        try:
+            with open(get_checkpoint_filepath(self.output_file_path), 'r') as f:
+                off, length, stream_id = f.read().split()
+                return int(off), int(length), bytes.fromhex(stream_id)
+        except Exception:
+            return 0, 0, None
+
+    def save(self):
+        try:
+            with open(get_checkpoint_filepath(self.output_file_path), 'w') as f:
+                f.write(f"{self.stream_off} {self.archive_len} {self.stream_id.hex()}")
+        except Exception as e:
+            print(f"[ERRO] Falha ao salvar checkpoint: {e}", file=sys.stderr)
+
+    def add_block(self, data: bytes):
+        # Na retomada o primeiro bloco pode trazer o fim de um segmento já salvo
+        if self.skip:
+            data, self.skip = data[self.skip:], 0
+        self.pending += data
+        header_size = BATCH_SEGMENT_HEADER.size
+        while len(self.pending) >= header_size:
+            stream_id, comp_len = BATCH_SEGMENT_HEADER.unpack_from(self.pending)
+            if len(self.pending) < header_size + comp_len:
+                return
+            if self.stream_id not in (None, stream_id):
+                raise ValueError("lote diferente do que estava sendo recebido; apague o checkpoint")
+            raw = zlib.decompress(bytes(self.pending[header_size:header_size + comp_len]))
+            self.f_out.write(raw)
+            self.f_out.flush()
+            del self.pending[:header_size + comp_len]
+            self.stream_id = stream_id
+            self.stream_off += header_size + comp_len
+            self.archive_len += len(raw)
+            self.save()
+
+    def close(self, end_received: bool):
+        self.f_out.close()
+        if not end_received:
+            return
+        out_dir = self.output_file_path[:-len(BATCH_SUFFIX)] if \
+            self.output_file_path.endswith(BATCH_SUFFIX) else self.output_file_path + '_arquivos'
+        os.makedirs(out_dir, exist_ok=True)
+        count = 0
+        with open(self.output_file_path, 'rb') as f:
+            while True:
+                header = f.read(BATCH_FILE_HEADER.size)
+                if len(header) < BATCH_FILE_HEADER.size:
+                    break
+                name_len, size = BATCH_FILE_HEADER.unpack(header)
+                name = os.path.basename(f.read(name_len).decode('utf-8'))
+                with open(os.path.join(out_dir, name), 'wb') as out:
+                    remaining = size
+                    while remaining:
+                        chunk = f.read(min(remaining, 64 * 1024))
+                        if not chunk:
+                            raise ValueError(f"lote truncado em '{name}'")
+                        out.write(chunk)
+                        remaining -= len(chunk)
+                count += 1
+        os.remove(self.output_file_path)
+        print(f"[LOTE] {count} arquivos extraídos em '{out_dir}/'.")
+
+
+# --- RS-485 Multiponto (Half-Duplex com Polling) ---
+# Só o mestre inicia: POLL(endereço, lote, ack) concede o barramento a um nó,
+# que responde com até 'lote' quadros DATA e devolve o barramento com EOT.
+# O ACK do mestre vai no POLL seguinte, então cada concessão custa apenas
+# duas inversões de sentido no barramento, qualquer que seja o lote.
+# Fluxo de cada nó: item 0 = nome do arquivo, depois os blocos, e um bloco
+# vazio como fim de arquivo. Não há checkpoint neste modo.
+
+def build_bus_frame(addr: int, frame_type: bytes, payload: bytes = b'') -> bytes:
+    body = bytes([addr]) + frame_type + struct.pack('<H', len(payload)) + payload
+    return body + calculate_crc32(body)
+
+
+def read_bus_frame(ser, timeout_sec: float):
+    """Retorna (endereço, tipo, payload), 'ERRO' para quadro corrompido ou None no timeout"""
+    head = receive_with_timeout(ser, RS485_HEADER_SIZE, timeout_sec)
+    if len(head) < RS485_HEADER_SIZE:
+        return None if not head else 'ERRO'
+    length = struct.unpack('<H', head[2:4])[0]
+    if length > 1 + max(BLOCK_SIZE, MAX_FILENAME_LEN):
+        ser.flushInput()
+        return 'ERRO'
+    rest = receive_with_timeout(ser, length + CRC_SIZE, 1)
+    if len(rest) < length + CRC_SIZE or calculate_crc32(head + rest[:length]) != rest[length:]:
+        ser.flushInput()
+        return 'ERRO'
+    return head[0], head[1:2], rest[:length]
+
+
+def rs485_reply_timeout(batch: int, baud: int, turnaround: float) -> float:
+    """
+    Espera pela resposta a uma concessão: folga fixa + inversão + tempo de linha
+    dos 'batch' quadros de dados e do EOT (8N1, 10 bits por byte). O
+    barramento simulado só entrega a rajada depois de todo esse tempo.
+    """
+    data_frame = RS485_HEADER_SIZE + 1 + BLOCK_SIZE + CRC_SIZE
+    airtime = (batch * data_frame + RS485_HEADER_SIZE + CRC_SIZE) * 10 / max(baud, 1)
+    return RS485_REPLY_SEC + turnaround + airtime
+
+
+def rs485_node(ser, addr: int, file_path: str, turnaround: float, idle_timeout: float = 30):
+    """Nó escravo: só transmite quando recebe POLL com o seu endereço"""
+    with open(file_path, 'rb') as f:
+        content = f.read()
+    items = [os.path.basename(file_path).encode('utf-8')]
+    items += [content[i:i + BLOCK_SIZE] for i in range(0, len(content), BLOCK_SIZE)]
+    items.append(b'')
+
+    base = 0
+    sent = 0
+    while base < len(items) and not received_interrupt:
+        frame = read_bus_frame(ser, idle_timeout)
+        if frame is None:
+            print(f"[RS485] Nó {addr}: sem POLL do mestre. Abortando.")
+            return False
+        if frame == 'ERRO' or frame[0] != addr or frame[1] != RS485_POLL:
+            continue
+
+        batch, ack = frame[2][0], frame[2][1]
+        offset = (ack - base) % 256
+        if offset < sent:
+            base += offset + 1
+        # Go-Back-N: cada concessão recomeça no primeiro item não confirmado
+        burst = b''
+        for index in range(base, min(base + batch, len(items))):
+            burst += build_bus_frame(addr, RS485_DATA, bytes([index % 256]) + items[index])
+        sent = min(batch, len(items) - base)
+        time.sleep(turnaround)
+        ser.write(burst + build_bus_frame(addr, RS485_EOT))
+    return base >= len(items)
+
+
+def rs485_master(ser, nodes: list, batch: int, turnaround: float, output_dir: str = '.',
+                 max_seconds: float = 0):
+    """
+    Mestre do barramento: concede a vez a cada nó em rodízio e confirma os
+    quadros no POLL seguinte. Devolve as métricas por nó.
+    """
+    state = {addr: {'expected': 0, 'file': None, 'name': None, 'done': False, 'acked_done': False,
+                    'grants': 0, 'bytes': 0, 'poll_times': [], 'finished_at': None, 'lost': 0, 'silent': 0}
+             for addr in nodes}
+    start = time.monotonic()
+    pending = list(nodes)
+    reply_timeout = rs485_reply_timeout(batch, ser.baudrate, turnaround)
+
+    while pending and not received_interrupt:
+        if max_seconds and time.monotonic() - start > max_seconds:
+            print("[RS485] Tempo máximo atingido.")
+            break
+        for addr in list(pending):
+            node = state[addr]
+            node['poll_times'].append(time.monotonic())
+            node['grants'] += 1
+            ack = (node['expected'] - 1) % 256
+            time.sleep(turnaround)
+            ser.write(build_bus_frame(addr, RS485_POLL, bytes([0 if node['done'] else batch, ack])))
+            if node['done']:
+                node['acked_done'] = True
+
+            while True:
+                frame = read_bus_frame(ser, reply_timeout)
+                if frame is None:
+                    node['lost'] += 1
+                    node['silent'] += 1
+                    break
+                node['silent'] = 0
+                if frame == 'ERRO':
+                    continue
+                frame_addr, frame_type, payload = frame
+                if frame_addr != addr:
+                    continue
+                if frame_type == RS485_EOT:
+                    break
+                if frame_type != RS485_DATA or node['done'] or payload[0] != node['expected'] % 256:
+                    continue
+
+                data = payload[1:]
+                if node['expected'] == 0:
+                    node['name'] = os.path.basename(data.decode('utf-8'))
+                    node['file'] = open(os.path.join(output_dir, f"recebido_no{addr}_{node['name']}"), 'wb')
+                elif data:
+                    node['file'].write(data)
+                    node['bytes'] += len(data)
+                else:
+                    node['file'].close()
+                    node['done'] = True
+                    node['finished_at'] = time.monotonic() - start
+                node['expected'] += 1
+
+            if node['acked_done'] and frame is not None:
+                pending.remove(addr)
+            elif node['silent'] >= MAX_RETRANS:
+                print(f"[RS485] Nó {addr} não responde. Retirado do rodízio.")
+                pending.remove(addr)
+
+    for node in state.values():
+        if node['file'] and not node['file'].closed:
+            node['file'].close()
+    return state, time.monotonic() - start
+
+
+def print_rs485_metrics(state: dict, elapsed: float):
+    for addr, node in state.items():
+        gaps = [b - a for a, b in zip(node['poll_times'], node['poll_times'][1:])]
+        gap_ms = sum(gaps) / len(gaps) * 1000 if gaps else 0
+        finished = f"{node['finished_at']:.2f} s" if node['finished_at'] is not None else "incompleto"
+        print(f"[METRICAS] Nó {addr}: {node['bytes']} bytes | concessões={node['grants']} "
+              f"sem resposta={node['lost']} | intervalo entre polls {gap_ms:.1f} ms | concluído em {finished}")
+    total = sum(node['bytes'] for node in state.values())
+    print(f"[METRICAS] Barramento: {total} bytes úteis em {elapsed:.2f} s ({total / max(elapsed, 1e-9):.0f} B/s)")
+
+
+# --- Gateway (Várias Portas, Um Laço de Eventos) ---
+class GatewaySession:
+    """
+    Receptor não bloqueante de uma porta: a mesma lógica de receptor_handler(),
+    alimentada pelos bytes que o laço de eventos entrega.
+    """
+
+    def __init__(self, ser: serial.Serial, port: str, metrics, index: int):
+        self.ser = ser
+        self.port = port
+        self.tag = os.path.basename(port)
+        self.metrics = metrics
+        self.offset = index * len(GATEWAY_METRICS)
+        self.buffer = bytearray()
+        self.f_out = None
+        self.output_file_path = None
+        self.expected_seq_num = 0
+        self.current_block = 0
+        self.last_activity = time.monotonic()
+
+    def count(self, field: str, amount: int = 1):
+        with self.metrics.get_lock():
+            self.metrics[self.offset + GATEWAY_METRICS.index(field)] += amount
+
+    def deadline(self) -> float:
+        if self.f_out is None:
+            return float('inf')
+        limit = GATEWAY_FRAME_SEC if self.buffer else GATEWAY_IDLE_SEC
+        return self.last_activity + limit
+
+    def feed(self, data: bytes, now: float):
+        self.buffer += data
+        self.last_activity = now
+        if self.f_out is None:
+            self.handle_start()
+        if self.f_out is not None:
+            self.handle_frames()
+
+    def handle_start(self):
+        while b'\n' in self.buffer:
+            line, _, rest = bytes(self.buffer).partition(b'\n')
+            if not line.startswith(START_TRANSMISSION_SIGNAL):
+                self.buffer = bytearray(rest)
+                continue
+            # Como no receptor, o que veio junto com o START é descartado
+            self.buffer.clear()
+            file_name = line[len(START_TRANSMISSION_SIGNAL):].strip().decode('utf-8')
+            self.output_file_path = f"recebido_{self.tag}_{os.path.basename(file_name)}"
+            self.f_out, last_block_received = open_output_file(self.output_file_path)
+            self.expected_seq_num = last_block_received % 2
+            self.current_block = last_block_received
+            self.ser.write(build_ack_status(last_block_received, file_prefix_crc(
+                self.output_file_path, last_block_received * BLOCK_SIZE)))
+            self.count('sessoes')
+            print(f"[GATEWAY] {self.tag}: recebendo '{file_name}' a partir do Bloco {last_block_received}.")
+            return
+        if len(self.buffer) > MAX_FILENAME_LEN + len(START_TRANSMISSION_SIGNAL):
+            self.buffer.clear()
+
+    def nak(self, drop: int = None):
+        self.ser.write(NAK_CHAR)
+        self.count('naks')
+        if drop is None:
+            self.buffer.clear()
+        else:
+            del self.buffer[:drop]
+
+    def handle_frames(self):
+        header_len = SEQ_SIZE + CRC_SIZE + 4
+        while self.buffer and self.f_out is not None:
+            if self.buffer[:1] == START_TRANSMISSION_SIGNAL[:1]:
+                if b'\n' not in self.buffer:
+                    return
+                # Emissor reiniciado: encerra a sessão atual e refaz o handshake
+                pending = bytes(self.buffer)
+                self.finish(False)
+                self.buffer += pending
+                self.handle_start()
+                continue
+            if self.buffer[:1] == END_SIGNAL[:1]:
+                if len(self.buffer) < len(END_SIGNAL):
+                    return
+                if bytes(self.buffer[:len(END_SIGNAL)]) == END_SIGNAL:
+                    self.finish(True)
+                else:
+                    self.nak(len(END_SIGNAL))
+                continue
+
+            if len(self.buffer) < header_len:
+                return
+            seq = self.buffer[0]
+            recv_crc = bytes(self.buffer[1:5])
+            data_len = struct.unpack('<I', self.buffer[5:9])[0]
+            if data_len > BLOCK_SIZE:
+                self.nak()
+                return
+            if len(self.buffer) < header_len + data_len:
+                return
+            data = bytes(self.buffer[header_len:header_len + data_len])
+            del self.buffer[:header_len + data_len]
+
+            if calculate_crc32(data) != recv_crc:
+                self.nak(0)
+                continue
+            if seq != self.expected_seq_num:
+                if seq == (1 - self.expected_seq_num):
+                    self.ser.write(ACK_CHAR)
+                else:
+                    self.nak(0)
+                continue
+
+            self.f_out.write(data)
+            self.f_out.flush()
+            self.ser.write(ACK_CHAR)
+            self.expected_seq_num = 1 - self.expected_seq_num
+            self.current_block += 1
+            save_checkpoint(self.output_file_path, self.current_block)
+            self.count('blocos')
+            self.count('bytes', data_len)
+
+    def check_timeout(self, now: float):
+        if now < self.deadline():
+            return
+        if self.buffer:
+            # Quadro incompleto: descarta e pede retransmissão
+            self.nak()
+            self.last_activity = now
+            return
+        self.finish(False)
+
+    def finish(self, end_received: bool):
+        self.f_out.close()
+        self.f_out = None
+        self.buffer.clear()
+        if end_received:
+            remove_checkpoint(self.output_file_path)
+            self.count('concluidas')
+            print(f"[GATEWAY] {self.tag}: '{self.output_file_path}' concluído ({self.current_block} blocos).")
+        else:
+            print(f"[GATEWAY] {self.tag}: timeout, checkpoint mantido em {self.current_block} blocos.")
+
+
+def gateway_worker(ports: list, indices: list, baud: int, metrics, stop):
+    """Laço de eventos (selectors) que atende todas as portas deste processo"""
+    if threading.current_thread() is threading.main_thread():
+        signal.signal(signal.SIGINT, signal_handler)
+    sel = selectors.DefaultSelector()
+    sessions = []
+    for port, index in zip(ports, indices):
+        ser = open_serial(port, baud)
+        ser.timeout = 0
+        session = GatewaySession(ser, port, metrics, index)
+        sel.register(ser.fileno(), selectors.EVENT_READ, session)
+        sessions.append(session)
+
+    try:
+        while not received_interrupt and not stop.is_set():
+            now = time.monotonic()
+            next_deadline = min(session.deadline() for session in sessions)
+            wait = min(max(0.0, next_deadline - now), 1.0)
+            for key, _ in sel.select(wait):
+                session = key.data
+                data = session.ser.read(MAX_PACKET_SIZE * 8)
+                if data:
+                    session.feed(data, time.monotonic())
+            now = time.monotonic()
+            for session in sessions:
+                session.check_timeout(now)
+    finally:
+        for session in sessions:
+            if session.f_out is not None:
+                session.finish(False)
+            sel.unregister(session.ser.fileno())
+            session.ser.close()
+        sel.close()
+
+
+def print_gateway_metrics(ports: list, metrics):
+    width = len(GATEWAY_METRICS)
+    with metrics.get_lock():
+        values = list(metrics)
+    print("[METRICAS] " + " | ".join(f"{name}={sum(values[i::width])}" for i, name in enumerate(GATEWAY_METRICS)))
+    for p_index, port in enumerate(ports):
+        row = values[p_index * width:(p_index + 1) * width]
+        if any(row):
+            print(f"    {port}: " + " ".join(f"{n}={v}" for n, v in zip(GATEWAY_METRICS, row)))
+
+
+def gateway_handler(ports: list, baud: int, workers: int, metrics_interval: int):
+    """
+    Atende muitas portas em um só processo (ou em poucos processos de trabalho,
+    com as portas divididas entre eles) e métricas em memória compartilhada.
+    """
+    metrics = multiprocessing.Array('q', len(ports) * len(GATEWAY_METRICS))
+    # O Ctrl+C do terminal chega a todos os processos, mas um SIGINT só no pai
+    # (kill, gerenciador de serviços) precisa ser repassado aos workers
+    stop = multiprocessing.Event()
+    workers = max(1, min(workers, len(ports)))
+    print(f"GATEWAY | {len(ports)} portas em {workers} processo(s).")
+
+    if workers == 1:
+        procs = []
+        worker = threading.Thread(target=gateway_worker,
+                                  args=(ports, list(range(len(ports))), baud, metrics, stop), daemon=True)
+        worker.start()
+        alive = worker.is_alive
+    else:
+        procs = [multiprocessing.Process(target=gateway_worker,
+                                         args=(ports[w::workers], list(range(len(ports)))[w::workers], baud, metrics, stop))
+                 for w in range(workers)]
+        for proc in procs:
+            proc.start()
+        alive = lambda: any(proc.is_alive() for proc in procs)
+
+    last_report = time.monotonic()
+    while alive() and not received_interrupt:
+        time.sleep(0.5)
+        if metrics_interval and time.monotonic() - last_report >= metrics_interval:
+            print_gateway_metrics(ports, metrics)
+            last_report = time.monotonic()
+
+    stop.set()
+    for proc in procs:
+        proc.join(GATEWAY_FRAME_SEC)
+        if proc.is_alive():
+            proc.terminate()
+            proc.join()
+    if not procs:
+        worker.join()
+    print_gateway_metrics(ports, metrics)
 
 
 # --- Main ---
+def open_serial(port: str, baud: int) -> serial.Serial:
+    ser = serial.Serial(
+        port=port,
+        baudrate=baud,
+        bytesize=serial.EIGHTBITS,
+        parity=serial.PARITY_NONE,
+        stopbits=serial.STOPBITS_ONE,
+        timeout=1,
+        rtscts=False,
+    )
+    print(f"Porta serial {port} aberta @ {baud} baud.")
+    ser.flushInput()
+    ser.flushOutput()
+    return ser
+
+
 def main():
     signal.signal(signal.SIGINT, signal_handler)
     parser = argparse.ArgumentParser()
-    parser.add_argument('modo', choices=['emissor', 'receptor'])
-    parser.add_argument('-p', '--port', required=True)
+    parser.add_argument('modo', choices=['emissor', 'receptor', 'retransmissor', 'gateway', 'mestre485', 'no485'])
+    parser.add_argument('-p', '--port', required=True, nargs='+', help="Porta serial (várias no modo gateway)")
     parser.add_argument('-b', '--baud', type=int, default=115200)
-    parser.add_argument('-f', '--file')
+    parser.add_argument('-f', '--file', nargs='+', help="Arquivo a enviar (vários com --compressao)")
+    parser.add_argument('-s', '--porta-saida', help="Porta do próximo enlace (modo retransmissor)")
+    parser.add_argument('--baud-saida', type=int, help="Baud rate do próximo enlace (padrão: -b)")
+    parser.add_argument('--taxa', type=float, default=0, help="Limite de escrita em bytes/s (0 = sem limite)")
+    parser.add_argument('--rajada', type=int, default=0, help="Tamanho da rajada em bytes")
+    parser.add_argument('--taxa-saida', type=float, default=0, help="Limite do enlace de saída (retransmissor)")
+    parser.add_argument('--rajada-saida', type=int, default=0, help="Rajada do enlace de saída (retransmissor)")
+    parser.add_argument('--controle', type=int, help="Porta UDP local para ajustar a taxa em tempo real")
+    parser.add_argument('--indice', action='store_true',
+                        help="Emissor: usa/gera o índice de blocos '<arquivo>.idx' (CRCs, CDC e SHA-256 em cache)")
+    parser.add_argument('--fec', type=int, default=0,
+                        help="Símbolos de paridade Reed-Solomon por bloco (0 = sem FEC; igual nos dois lados)")
+    parser.add_argument('--entrelacamento', type=int, default=1,
+                        help="Profundidade do entrelaçamento com --fec (blocos por grupo; igual nos dois lados)")
+    parser.add_argument('--janela-max', type=int, default=1,
+                        help="Quadros em voo no máximo, com janela AIMD (1 = Stop-and-Wait; igual nos dois lados)")
+    parser.add_argument('--compressao', choices=['arquivo', 'solido'],
+                        help="Lote comprimido: um contexto por arquivo ou um contexto sólido (igual nos dois lados)")
+    parser.add_argument('--reset-solido', type=int, default=BATCH_RESET_BYTES,
+                        help="Bytes originais entre pontos de reinício do contexto sólido")
+    parser.add_argument('--nome-lote', default='lote', help="Nome do lote enviado no START")
+    parser.add_argument('--nos', type=int, nargs='+', help="Endereços dos nós (modo mestre485)")
+    parser.add_argument('--endereco', type=int, help="Endereço deste nó, 1-247 (modo no485)")
+    parser.add_argument('--lote', type=int, default=8, help="Quadros por concessão do barramento (mestre485)")
+    parser.add_argument('--turnaround', type=float, default=2.0, help="Atraso de inversão do barramento RS-485 em ms")
+    parser.add_argument('--rts-direcao', action='store_true',
+                        help="RS-485: controla o sentido do transceptor pelo RTS (Linux)")
+    parser.add_argument('--workers', type=int, default=1, help="Processos de trabalho do modo gateway")
+    parser.add_argument('--intervalo-metricas', type=int, default=10, help="Segundos entre relatórios do gateway")
     args = parser.parse_args()
 
-    generate_crc_table()
+    if args.modo != 'gateway' and len(args.port) > 1:
+        parser.error("Apenas o modo 'gateway' aceita várias portas em '-p'.")
+    if args.modo == 'mestre485' and (not args.nos or not all(1 <= addr <= 247 for addr in args.nos)):
+        parser.error("O modo 'mestre485' requer '--nos' com endereços entre 1 e 247.")
+    if args.file and len(args.file) > 1 and not (args.modo == 'emissor' and args.compressao):
+        parser.error("Vários arquivos em '-f' exigem o modo 'emissor' com '--compressao'.")
+    if args.reset_solido <= 0:
+        parser.error("'--reset-solido' deve ser positivo.")
+    if args.compressao and args.modo not in ('emissor', 'receptor'):
+        parser.error("'--compressao' está disponível apenas nos modos 'emissor' e 'receptor'.")
+    if args.compressao and args.indice:
+        parser.error("'--indice' não se aplica a '--compressao' (o fluxo do lote é regenerado a cada envio).")
+    if args.modo == 'no485' and (not args.file or not args.endereco or not 1 <= args.endereco <= 247):
+        parser.error("O modo 'no485' requer '-f/--file' e '--endereco' entre 1 e 247.")
+    if not 1 <= args.lote <= RS485_MAX_BATCH:
+        parser.error(f"'--lote' deve estar entre 1 e {RS485_MAX_BATCH}.")
+
+    fec = None
+    if args.fec:
+        if args.modo not in ('emissor', 'receptor'):
+            parser.error("'--fec' está disponível apenas nos modos 'emissor' e 'receptor'.")
+        if not 2 <= args.fec <= 255 - fec_codeword_size(0):
+            parser.error(f"'--fec' deve estar entre 2 e {255 - fec_codeword_size(0)}.")
+        if not 1 <= args.entrelacamento <= 255:
+            parser.error("'--entrelacamento' deve estar entre 1 e 255.")
+        fec = (args.fec, args.entrelacamento)
+    elif args.entrelacamento != 1:
+        parser.error("'--entrelacamento' requer '--fec'.")
+    if args.janela_max != 1:
+        if args.modo not in ('emissor', 'receptor') or fec:
+            parser.error("'--janela-max' está disponível apenas em 'emissor'/'receptor' sem '--fec'.")
+        if not 1 <= args.janela_max <= MAX_WINDOW:
+            parser.error(f"'--janela-max' deve estar entre 1 e {MAX_WINDOW}.")
+
+    if args.modo == 'emissor' and not args.file:
+        parser.error("O modo 'emissor' requer '-f/--file'.")
+    if args.modo == 'retransmissor' and not args.porta_saida:
+        parser.error("O modo 'retransmissor' requer '-s/--porta-saida'.")
 
     try:
-        ser = serial.Serial(
-            port=args.port,
-            baudrate=args.baud,
-            bytesize=serial.EIGHTBITS,
-            parity=serial.PARITY_NONE,
-            stopbits=serial.STOPBITS_ONE,
-            timeout=1,
-            rtscts=False,
-        )
-        print(f"Porta serial {args.port} aberta @ {args.baud} baud.")
-        ser.flushInput()
-        ser.flushOutput()
+        if args.modo == 'gateway':
+            gateway_handler(args.port, args.baud, args.workers, args.intervalo_metricas)
+            return
 
-        if args.modo == 'emissor':
-            if not args.file:
-                parser.error("O modo 'emissor' requer '-f/--file'.")
-            emissor_handler(ser, args.file)
+        buckets = {}
+        ser = open_serial(args.port[0], args.baud)
+        if args.taxa or args.controle:
+            buckets['entrada'] = TokenBucket(args.taxa, args.rajada)
+            ser = ShapedSerial(ser, buckets['entrada'])
+
+        ser_out = None
+        if args.modo == 'retransmissor':
+            ser_out = open_serial(args.porta_saida, args.baud_saida or args.baud)
+            if args.taxa_saida or args.controle:
+                buckets['saida'] = TokenBucket(args.taxa_saida, args.rajada_saida)
+                ser_out = ShapedSerial(ser_out, buckets['saida'])
+
+        if args.controle:
+            threading.Thread(target=rate_control_server, args=(args.controle, buckets), daemon=True).start()
+
+        if args.modo in ('mestre485', 'no485'):
+            turnaround = args.turnaround / 1000
+            if args.rts_direcao:
+                import serial.rs485
+                ser.rs485_mode = serial.rs485.RS485Settings(delay_before_tx=turnaround,
+                                                            delay_before_rx=turnaround)
+            if args.modo == 'mestre485':
+                print_rs485_metrics(*rs485_master(ser, args.nos, args.lote, turnaround))
+            else:
+                rs485_node(ser, args.endereco, args.file[0], turnaround)
+            ser.close()
+        elif args.modo == 'emissor':
+            if args.compressao:
+                with tempfile.TemporaryDirectory() as tmp_dir:
+                    stream_path = os.path.join(tmp_dir, args.nome_lote + BATCH_SUFFIX)
+                    build_batch_stream(args.file, args.compressao, args.reset_solido, stream_path)
+                    emissor_handler(ser, stream_path, False, fec, args.janela_max)
+            else:
+                emissor_handler(ser, args.file[0], args.indice, fec, args.janela_max)
+        elif args.modo == 'retransmissor':
+            relay_handler(ser, ser_out)
         else:
-            receptor_handler(ser)
+            receptor_handler(ser, fec, args.janela_max > 1, bool(args.compressao))
 
     except Exception as e:
         print(f"[ERRO FATAL] {e}", file=sys.stderr)